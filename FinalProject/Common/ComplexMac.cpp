@@ -0,0 +1,527 @@
+#include "ComplexMac.h"
+#include <cstring>
+#include <type_traits>
+#include <juce_core/juce_core.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+ #define CONVOLUTION_MAC_X86 1
+ #include <immintrin.h>
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+ #define CONVOLUTION_MAC_NEON 1
+ #include <arm_neon.h>
+#endif
+
+// GCC/Clang need per-function target attributes so the wider variants compile without raising the
+// baseline ISA of the whole plugin (and without per-file flags that break universal macOS builds).
+#if defined(__GNUC__) || defined(__clang__)
+ #define CONVOLUTION_MAC_TARGET(isa) __attribute__((target(isa)))
+#else
+ #define CONVOLUTION_MAC_TARGET(isa)
+#endif
+
+namespace ComplexMac
+{
+namespace
+{
+    //==========================================================================
+    // Compact IR spectra. Each ISA expands 16-bit h values to floats in registers; the kernels
+    // below scale them by the partition's scale and run the same MAC as for fp32, so only the IR
+    // stream shrinks.
+#if CONVOLUTION_MAC_X86
+    // fp16 without F16C: shift the exponent and mantissa into float position and let one multiply
+    // by 2^112 rebias the exponent, which also normalises subnormals. Inf/NaN never get stored.
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("sse2")
+    inline __m128 decodeSse2(const uint16_t* p) noexcept
+    {
+        const __m128i bits = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+        if constexpr (format == SpectrumFormat::bf16)
+            return _mm_castsi128_ps(_mm_slli_epi32(bits, 16));
+
+        const __m128i sign = _mm_slli_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x8000)), 16);
+        const __m128i magnitude = _mm_slli_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7fff)), 13);
+        const __m128 value = _mm_mul_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+        return _mm_or_ps(value, _mm_castsi128_ps(sign));
+    }
+
+    // The AVX2 variant converts fp16 with F16C. Real AVX2 CPUs all have it (it arrived a generation
+    // earlier), but some VMs hide it, so fp16 falls back to the SSE2 variant there (see
+    // getCompactMultiKernel).
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("avx2,fma,f16c")
+    inline __m256 decodeAvx2(const uint16_t* p) noexcept
+    {
+        const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if constexpr (format == SpectrumFormat::bf16)
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16));
+        else
+            return _mm256_cvtph_ps(bits);
+    }
+
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("avx512f")
+    inline __m512 decodeAvx512(const uint16_t* p) noexcept
+    {
+        // The all-lanes maskz forms are the plain conversions; GCC 12 warns on the unmasked ones.
+        const __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __mmask16 all = 0xffff;
+        if constexpr (format == SpectrumFormat::bf16)
+            return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(all, _mm512_maskz_cvtepu16_epi32(all, bits), 16));
+        else
+            return _mm512_maskz_cvtph_ps(all, bits);
+    }
+
+#endif
+
+#if CONVOLUTION_MAC_NEON
+    template <SpectrumFormat format>
+    inline float32x4_t decodeNeon(const uint16_t* p) noexcept
+    {
+        const uint16x4_t bits = vld1_u16(p);
+        if constexpr (format == SpectrumFormat::bf16)
+            return vreinterpretq_f32_u32(vshll_n_u16(bits, 16));
+        else
+            return vcvt_f32_f16(vreinterpret_f16_u16(bits));
+    }
+
+#endif
+
+    //==========================================================================
+    // Multi-lane kernels. One template per ISA serves fp32 and compact IR spectra: the h block is
+    // loaded (or decoded and scaled) once, then every lane runs the same per-bin steps, so the
+    // results do not depend on how many lanes share a call.
+    template <SpectrumFormat format>
+    using HSample = std::conditional_t<format == SpectrumFormat::fp32, float, uint16_t>;
+
+    template <SpectrumFormat format>
+    inline float loadHScalar(const HSample<format>* p, int k, float hScale) noexcept
+    {
+        if constexpr (format == SpectrumFormat::fp32)
+            return p[k];
+        else
+            return decode(format, p[k]) * hScale;
+    }
+
+    template <SpectrumFormat format>
+    void multiMacScalarTail(const Lane* lanes, int numLanes, const HSample<format>* hRe, const HSample<format>* hIm,
+                            float hScale, int start, int count) noexcept
+    {
+        for (int k = start; k < count; ++k)
+        {
+            const float hr = loadHScalar<format>(hRe, k, hScale);
+            const float hi = loadHScalar<format>(hIm, k, hScale);
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const Lane& lane = lanes[l];
+                lane.accRe[k] += (lane.xRe[k] * hr) - (lane.xIm[k] * hi);
+                lane.accIm[k] += (lane.xRe[k] * hi) + (lane.xIm[k] * hr);
+            }
+        }
+    }
+
+    template <SpectrumFormat format>
+    void multiMacScalar(const Lane* lanes, int numLanes, const HSample<format>* hRe, const HSample<format>* hIm,
+                        float hScale, int count) noexcept
+    {
+        multiMacScalarTail<format>(lanes, numLanes, hRe, hIm, hScale, 0, count);
+    }
+
+#if CONVOLUTION_MAC_X86
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("sse2")
+    inline __m128 loadHSse2(const HSample<format>* p, __m128 scale) noexcept
+    {
+        if constexpr (format == SpectrumFormat::fp32)
+            return _mm_loadu_ps(p);
+        else
+            return _mm_mul_ps(decodeSse2<format>(p), scale);
+    }
+
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("sse2")
+    void multiMacSse2(const Lane* lanes, int numLanes, const HSample<format>* hRe, const HSample<format>* hIm,
+                      float hScale, int count) noexcept
+    {
+        const __m128 scale = _mm_set1_ps(hScale);
+        int k = 0;
+        for (; k + 4 <= count; k += 4)
+        {
+            const __m128 hr = loadHSse2<format>(hRe + k, scale);
+            const __m128 hi = loadHSse2<format>(hIm + k, scale);
+
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const Lane& lane = lanes[l];
+                const __m128 xr = _mm_loadu_ps(lane.xRe + k);
+                const __m128 xi = _mm_loadu_ps(lane.xIm + k);
+
+                const __m128 re = _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi));
+                const __m128 im = _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr));
+                _mm_storeu_ps(lane.accRe + k, _mm_add_ps(_mm_loadu_ps(lane.accRe + k), re));
+                _mm_storeu_ps(lane.accIm + k, _mm_add_ps(_mm_loadu_ps(lane.accIm + k), im));
+            }
+        }
+
+        multiMacScalarTail<format>(lanes, numLanes, hRe, hIm, hScale, k, count);
+    }
+
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("avx2,fma,f16c")
+    inline __m256 loadHAvx2(const HSample<format>* p, __m256 scale) noexcept
+    {
+        if constexpr (format == SpectrumFormat::fp32)
+            return _mm256_loadu_ps(p);
+        else
+            return _mm256_mul_ps(decodeAvx2<format>(p), scale);
+    }
+
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("avx2,fma,f16c")
+    void multiMacAvx2(const Lane* lanes, int numLanes, const HSample<format>* hRe, const HSample<format>* hIm,
+                      float hScale, int count) noexcept
+    {
+        const __m256 scale = _mm256_set1_ps(hScale);
+        int k = 0;
+        for (; k + 8 <= count; k += 8)
+        {
+            const __m256 hr = loadHAvx2<format>(hRe + k, scale);
+            const __m256 hi = loadHAvx2<format>(hIm + k, scale);
+
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const Lane& lane = lanes[l];
+                const __m256 xr = _mm256_loadu_ps(lane.xRe + k);
+                const __m256 xi = _mm256_loadu_ps(lane.xIm + k);
+
+                __m256 re = _mm256_loadu_ps(lane.accRe + k);
+                __m256 im = _mm256_loadu_ps(lane.accIm + k);
+                re = _mm256_fnmadd_ps(xi, hi, _mm256_fmadd_ps(xr, hr, re));
+                im = _mm256_fmadd_ps(xi, hr, _mm256_fmadd_ps(xr, hi, im));
+                _mm256_storeu_ps(lane.accRe + k, re);
+                _mm256_storeu_ps(lane.accIm + k, im);
+            }
+        }
+
+        multiMacScalarTail<format>(lanes, numLanes, hRe, hIm, hScale, k, count);
+    }
+
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("avx512f")
+    inline __m512 loadHAvx512(const HSample<format>* p, __m512 scale) noexcept
+    {
+        if constexpr (format == SpectrumFormat::fp32)
+            return _mm512_loadu_ps(p);
+        else
+            return _mm512_mul_ps(decodeAvx512<format>(p), scale);
+    }
+
+    template <SpectrumFormat format>
+    CONVOLUTION_MAC_TARGET("avx512f")
+    void multiMacAvx512(const Lane* lanes, int numLanes, const HSample<format>* hRe, const HSample<format>* hIm,
+                        float hScale, int count) noexcept
+    {
+        const __m512 scale = _mm512_set1_ps(hScale);
+        int k = 0;
+        for (; k + 16 <= count; k += 16)
+        {
+            const __m512 hr = loadHAvx512<format>(hRe + k, scale);
+            const __m512 hi = loadHAvx512<format>(hIm + k, scale);
+
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const Lane& lane = lanes[l];
+                const __m512 xr = _mm512_loadu_ps(lane.xRe + k);
+                const __m512 xi = _mm512_loadu_ps(lane.xIm + k);
+
+                __m512 re = _mm512_loadu_ps(lane.accRe + k);
+                __m512 im = _mm512_loadu_ps(lane.accIm + k);
+                re = _mm512_fnmadd_ps(xi, hi, _mm512_fmadd_ps(xr, hr, re));
+                im = _mm512_fmadd_ps(xi, hr, _mm512_fmadd_ps(xr, hi, im));
+                _mm512_storeu_ps(lane.accRe + k, re);
+                _mm512_storeu_ps(lane.accIm + k, im);
+            }
+        }
+
+        if (k >= count)
+            return;
+
+        if constexpr (format == SpectrumFormat::fp32)
+        {
+            // Masked tail keeps the FMA rounding consistent for every bin of the variant.
+            const auto mask = static_cast<__mmask16>((1u << (count - k)) - 1u);
+            const __m512 hr = _mm512_maskz_loadu_ps(mask, hRe + k);
+            const __m512 hi = _mm512_maskz_loadu_ps(mask, hIm + k);
+
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const Lane& lane = lanes[l];
+                const __m512 xr = _mm512_maskz_loadu_ps(mask, lane.xRe + k);
+                const __m512 xi = _mm512_maskz_loadu_ps(mask, lane.xIm + k);
+
+                __m512 re = _mm512_maskz_loadu_ps(mask, lane.accRe + k);
+                __m512 im = _mm512_maskz_loadu_ps(mask, lane.accIm + k);
+                re = _mm512_fnmadd_ps(xi, hi, _mm512_fmadd_ps(xr, hr, re));
+                im = _mm512_fmadd_ps(xi, hr, _mm512_fmadd_ps(xr, hi, im));
+                _mm512_mask_storeu_ps(lane.accRe + k, mask, re);
+                _mm512_mask_storeu_ps(lane.accIm + k, mask, im);
+            }
+        }
+        else
+        {
+            multiMacScalarTail<format>(lanes, numLanes, hRe, hIm, hScale, k, count);
+        }
+    }
+#endif
+
+#if CONVOLUTION_MAC_NEON
+    template <SpectrumFormat format>
+    inline float32x4_t loadHNeon(const HSample<format>* p, float hScale) noexcept
+    {
+        if constexpr (format == SpectrumFormat::fp32)
+            return vld1q_f32(p);
+        else
+            return vmulq_n_f32(decodeNeon<format>(p), hScale);
+    }
+
+    template <SpectrumFormat format>
+    void multiMacNeon(const Lane* lanes, int numLanes, const HSample<format>* hRe, const HSample<format>* hIm,
+                      float hScale, int count) noexcept
+    {
+        int k = 0;
+        for (; k + 4 <= count; k += 4)
+        {
+            const float32x4_t hr = loadHNeon<format>(hRe + k, hScale);
+            const float32x4_t hi = loadHNeon<format>(hIm + k, hScale);
+
+            for (int l = 0; l < numLanes; ++l)
+            {
+                const Lane& lane = lanes[l];
+                const float32x4_t xr = vld1q_f32(lane.xRe + k);
+                const float32x4_t xi = vld1q_f32(lane.xIm + k);
+
+                float32x4_t re = vld1q_f32(lane.accRe + k);
+                float32x4_t im = vld1q_f32(lane.accIm + k);
+                re = vfmsq_f32(vfmaq_f32(re, xr, hr), xi, hi);
+                im = vfmaq_f32(vfmaq_f32(im, xr, hi), xi, hr);
+                vst1q_f32(lane.accRe + k, re);
+                vst1q_f32(lane.accIm + k, im);
+            }
+        }
+
+        multiMacScalarTail<format>(lanes, numLanes, hRe, hIm, hScale, k, count);
+    }
+#endif
+
+    // The fp32 entry points have no scale argument.
+    template <void (*kernel)(const Lane*, int, const float*, const float*, float, int) noexcept>
+    void unscaled(const Lane* lanes, int numLanes, const float* hRe, const float* hIm, int count) noexcept
+    {
+        kernel(lanes, numLanes, hRe, hIm, 1.0f, count);
+    }
+
+    template <SpectrumFormat format>
+    CompactMultiKernel selectCompactMultiKernel(Isa isa)
+    {
+        switch (isa)
+        {
+           #if CONVOLUTION_MAC_X86
+            case Isa::sse2:   return multiMacSse2<format>;
+            case Isa::avx2:   return multiMacAvx2<format>;
+            case Isa::avx512: return multiMacAvx512<format>;
+           #endif
+           #if CONVOLUTION_MAC_NEON
+            case Isa::neon:   return multiMacNeon<format>;
+           #endif
+            default:          return multiMacScalar<format>;
+        }
+    }
+
+#if CONVOLUTION_MAC_X86
+    // juce::SystemStats does not report F16C, so read CPUID leaf 1 (ECX bit 29) directly.
+    bool hasF16C()
+    {
+       #if defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[2] & (1 << 29)) != 0;
+       #else
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & (1u << 29)) != 0;
+       #endif
+    }
+#endif
+
+    // The ISA whose variant runs compact spectra of `format` for `isa`: the same one, except fp16
+    // on AVX2 without F16C, which uses the SSE2 decoder.
+    Isa getCompactIsa(SpectrumFormat format, Isa isa)
+    {
+       #if CONVOLUTION_MAC_X86
+        static const bool f16c = hasF16C();
+        if (format == SpectrumFormat::fp16 && isa == Isa::avx2 && !f16c)
+            return Isa::sse2;
+       #else
+        juce::ignoreUnused(format);
+       #endif
+        return isa;
+    }
+
+    Isa selectIsa()
+    {
+        for (auto isa : { Isa::avx512, Isa::avx2, Isa::sse2, Isa::neon })
+            if (isSupported(isa))
+                return isa;
+
+        return Isa::scalar;
+    }
+}
+
+Isa getActiveIsa()
+{
+    static const Isa active = selectIsa();
+    return active;
+}
+
+bool isSupported(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::scalar: return true;
+       #if CONVOLUTION_MAC_X86
+        case Isa::sse2:   return juce::SystemStats::hasSSE2();
+        case Isa::avx2:   return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+        case Isa::avx512: return juce::SystemStats::hasAVX512F();
+       #endif
+       #if CONVOLUTION_MAC_NEON
+        case Isa::neon:   return true;
+       #endif
+        default:          return false;
+    }
+}
+
+const char* getIsaName(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::sse2:   return "SSE2";
+        case Isa::avx2:   return "AVX2+FMA";
+        case Isa::avx512: return "AVX-512";
+        case Isa::neon:   return "NEON";
+        default:          return "scalar";
+    }
+}
+
+MultiKernel getMultiKernel()
+{
+    static const MultiKernel active = getMultiKernel(getActiveIsa());
+    return active;
+}
+
+MultiKernel getMultiKernel(Isa isa)
+{
+    if (!isSupported(isa))
+        return nullptr;
+
+    constexpr auto fp32 = SpectrumFormat::fp32;
+    switch (isa)
+    {
+       #if CONVOLUTION_MAC_X86
+        case Isa::sse2:   return unscaled<multiMacSse2<fp32>>;
+        case Isa::avx2:   return unscaled<multiMacAvx2<fp32>>;
+        case Isa::avx512: return unscaled<multiMacAvx512<fp32>>;
+       #endif
+       #if CONVOLUTION_MAC_NEON
+        case Isa::neon:   return unscaled<multiMacNeon<fp32>>;
+       #endif
+        default:          return unscaled<multiMacScalar<fp32>>;
+    }
+}
+
+CompactMultiKernel getCompactMultiKernel(SpectrumFormat format)
+{
+    static const CompactMultiKernel fp16 = getCompactMultiKernel(SpectrumFormat::fp16, getActiveIsa());
+    static const CompactMultiKernel bf16 = getCompactMultiKernel(SpectrumFormat::bf16, getActiveIsa());
+    return format == SpectrumFormat::fp16 ? fp16 : format == SpectrumFormat::bf16 ? bf16 : nullptr;
+}
+
+CompactMultiKernel getCompactMultiKernel(SpectrumFormat format, Isa isa)
+{
+    if (!isSupported(isa))
+        return nullptr;
+
+    switch (format)
+    {
+        case SpectrumFormat::fp16: return selectCompactMultiKernel<SpectrumFormat::fp16>(getCompactIsa(format, isa));
+        case SpectrumFormat::bf16: return selectCompactMultiKernel<SpectrumFormat::bf16>(isa);
+        default:                   return nullptr;
+    }
+}
+
+uint16_t encode(SpectrumFormat format, float value) noexcept
+{
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    if (format == SpectrumFormat::bf16)
+    {
+        // Round to nearest even on the 16 dropped mantissa bits.
+        bits += 0x7fffu + ((bits >> 16) & 1u);
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+    // fp16, round to nearest even. Magnitudes past the largest finite half clamp to it, so no
+    // Inf ever reaches the decoders.
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    bits &= 0x7fffffffu;
+
+    uint32_t half = 0;
+    if (bits >= 0x477ff000u)           // rounds to 65520 or more
+    {
+        half = 0x7bffu;
+    }
+    else if (bits < 0x38800000u)       // below the smallest normal half: let the FPU round the subnormal
+    {
+        float magnitude = 0.0f;
+        std::memcpy(&magnitude, &bits, sizeof(bits));
+        magnitude += 0.5f;
+        uint32_t rounded = 0;
+        std::memcpy(&rounded, &magnitude, sizeof(rounded));
+        half = rounded - 0x3f000000u;
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (bits >> 13) & 1u;
+        bits += 0xc8000fffu + mantissaOdd; // rebias the exponent (-112) and round
+        half = bits >> 13;
+    }
+
+    return static_cast<uint16_t>(half | sign);
+}
+
+float decode(SpectrumFormat format, uint16_t value) noexcept
+{
+    uint32_t bits = 0;
+    if (format == SpectrumFormat::bf16)
+    {
+        bits = static_cast<uint32_t>(value) << 16;
+    }
+    else
+    {
+        // Same rebias-by-multiply as the SSE2 decoder.
+        const uint32_t magnitudeBits = static_cast<uint32_t>(value & 0x7fffu) << 13;
+        float magnitude = 0.0f;
+        std::memcpy(&magnitude, &magnitudeBits, sizeof(magnitude));
+        magnitude *= 0x1.0p112f;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= static_cast<uint32_t>(value & 0x8000u) << 16;
+    }
+
+    float result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+// Complex multiply-accumulate over split real/imag spectra, shared by both engine builds:
+//
+//     acc[k] += x[k] * h[k]    for k in [0, count)
+//
+// for one or more channels (lanes) at a time. One kernel is selected at runtime from the CPU's features (AVX-512F, AVX2 + FMA, SSE2 on x86;
+// NEON on arm64) with a portable scalar fallback. Loads and stores are unaligned so any float
+// buffer works, though 64-byte aligned planes stream best.
+//
+// Tolerance: the SSE2 and scalar kernels evaluate acc + (xr*hr - xi*hi) in the same order and
+// agree bit-for-bit unless the compiler contracts the scalar loop. The FMA kernels (AVX2,
+// AVX-512, NEON) round once per fused step instead, so each bin may differ from the scalar
+// result by at most 4 * FLT_EPSILON * sum(|x| * |h|) accumulated over the calls for that bin,
+// i.e. below -130 dB relative to the partition energy for typical IRs.
+namespace ComplexMac
+{
+    enum class Isa
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    // Best variant the running CPU supports; resolved once and cached.
+    Isa getActiveIsa();
+
+    // Whether this build and CPU can run a variant. DirectFir and Resampler pick theirs with it too.
+    bool isSupported(Isa isa);
+
+    const char* getIsaName(Isa isa);
+
+    // Reduced-precision IR spectra: the h planes are 16-bit and each partition carries one float
+    // scale, so the kernel computes acc[k] += x[k] * (decode(h[k]) * hScale). fp16 keeps 11
+    // significant bits (the scale keeps partitions in its normal range); bf16 keeps 8 but has
+    // float's range. Both halve the IR stream the MAC reads. Decoding is exact, so variants of one
+    // format differ only like the float kernels.
+    enum class SpectrumFormat
+    {
+        fp32,
+        fp16,
+        bf16
+    };
+
+    // Several channels share one IR spectrum: every lane runs
+    //
+    //     lane.acc[k] += lane.x[k] * h[k]
+    //
+    // but each block of h is loaded (and for compact spectra decoded) once and reused from registers
+    // for all lanes, so a partition is streamed once per block however many channels read it. A
+    // lane's result does not depend on how many lanes share the call. Lanes must not share an
+    // accumulator.
+    struct Lane
+    {
+        float* accRe;
+        float* accIm;
+        const float* xRe;
+        const float* xIm;
+    };
+
+    using MultiKernel = void (*)(const Lane* lanes, int numLanes,
+                                 const float* hRe, const float* hIm,
+                                 int count) noexcept;
+
+    using CompactMultiKernel = void (*)(const Lane* lanes, int numLanes,
+                                        const uint16_t* hRe, const uint16_t* hIm,
+                                        float hScale, int count) noexcept;
+
+    // Best variant for the running CPU, or a specific one (nullptr if this build/CPU cannot run
+    // it; used for A/B checks).
+    MultiKernel getMultiKernel();
+    MultiKernel getMultiKernel(Isa isa);
+    // nullptr for fp32, which uses getMultiKernel().
+    CompactMultiKernel getCompactMultiKernel(SpectrumFormat format);
+    CompactMultiKernel getCompactMultiKernel(SpectrumFormat format, Isa isa);
+
+    // Round-to-nearest-even conversions used when the IR is loaded and by the scalar kernels.
+    uint16_t encode(SpectrumFormat format, float value) noexcept;
+    float decode(SpectrumFormat format, uint16_t value) noexcept;
+}
@@ -0,0 +1,1044 @@
+#include "ConvolutionEngine.h"
+#include "RealtimeCheck.h"
+#include "Semaphore.h"
+
+namespace
+{
+    // Input below this (about -180 dBFS) counts as silence; skipping it changes the output by
+    // less than the FFT path's own rounding.
+    constexpr float silenceThreshold = 1.0e-9f;
+
+    bool isSilent(const float* samples, int numSamples) noexcept
+    {
+        return std::all_of(samples, samples + numSamples,
+                           [](float x) { return std::abs(x) <= silenceThreshold; });
+    }
+}
+
+// Background thread that convolves the tail tiers handed off by the audio thread.
+class ConvolutionEngine::State::TailWorker : public juce::Thread
+{
+public:
+    TailWorker(State& ownerState, int index, int maxFftSize, int numOutputs)
+        : juce::Thread("Convolution tail " + juce::String(index)), owner(ownerState), workerIndex(index)
+    {
+        scratch.allocate(maxFftSize, numOutputs);
+    }
+
+    ~TailWorker() override
+    {
+        signalThreadShouldExit();
+        wakeup.signal();
+        stopThread(1000);
+    }
+
+    // Called by the audio thread for every job it submits; never locks.
+    void wake() noexcept { wakeup.signal(); }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            // A held worker (ConvolutionEngine::holdTailWorkers) polls until it is released.
+            if (owner.tailWorkersHeld.load(std::memory_order_relaxed))
+            {
+                sleep(1);
+                continue;
+            }
+
+            {
+                const RealtimeCheck::ScopedRealtimeSection realtimeSection;
+                owner.runTailJobs(workerIndex, scratch);
+            }
+
+            // A job submitted since the jobs were scanned has already been signalled, so this
+            // returns straight away; otherwise the worker sleeps until the next one.
+            wakeup.wait();
+        }
+    }
+
+private:
+    State& owner;
+    const int workerIndex;
+    FFTScratch scratch;
+    Semaphore wakeup;
+};
+
+void ConvolutionEngine::State::FFTScratch::allocate(int maxFftSize, int numOutputs)
+{
+    fftWork.assign(static_cast<size_t>(maxFftSize * 2), 0.0f);
+    timeDomain.assign(static_cast<size_t>(maxFftSize), 0.0f);
+    accumSpectrum.allocate(numOutputs, maxFftSize / 2 + 1);
+    outputActive.assign(static_cast<size_t>(numOutputs), 0);
+}
+
+//==============================================================================
+ConvolutionEngine::ConvolutionEngine() = default;
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+    delete pendingState.exchange(nullptr, std::memory_order_acq_rel);
+    delete fadingState;
+    delete activeState;
+    releaseRetiredStates();
+}
+
+void ConvolutionEngine::prepare(double newSampleRate, int newBlockSize, int numChannels)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = std::max(1, newBlockSize);
+    cpuMeter.prepare(newSampleRate);
+    numChannels = std::max(1, numChannels);
+    preparedChannels.store(numChannels);
+
+    dryBuffer.setSize(numChannels, maxBlockSize);
+    fadeBuffer.setSize(numChannels, maxBlockSize);
+    fadeDryBuffer.setSize(numChannels, maxBlockSize);
+    activePointers.assign(static_cast<size_t>(numChannels), nullptr);
+    fadePointers.assign(static_cast<size_t>(numChannels), nullptr);
+    dryPointers.assign(static_cast<size_t>(numChannels), nullptr);
+    fadeDryPointers.assign(static_cast<size_t>(numChannels), nullptr);
+
+    // Audio is stopped, so the state is rebuilt for the new channel count and installed directly.
+    std::lock_guard<std::mutex> lock(stateBuildMutex);
+    delete pendingState.exchange(nullptr, std::memory_order_acq_rel);
+    delete fadingState;
+    delete activeState;
+    fadingState = activeState = nullptr;
+    fadeLength = fadePosition = 0;
+    releaseRetiredStates();
+
+    if (latestIR)
+    {
+        activeState = createState(latestIR).release();
+        partitionSize.store(activeState->getPartitionSize());
+        latencySamples.store(activeState->getLatencySamples());
+    }
+}
+
+void ConvolutionEngine::reset()
+{
+    // Audio is stopped: finish any crossfade on the spot and clear the active state's history.
+    delete fadingState;
+    fadingState = nullptr;
+    fadeLength = fadePosition = 0;
+
+    if (activeState)
+        activeState->reset();
+}
+
+void ConvolutionEngine::setIR(const std::shared_ptr<const IRData>& ir)
+{
+    if (!ir)
+        return;
+
+    // Spectra are precomputed in IRLoader; everything else the IR needs is allocated here, on
+    // the calling thread, before the audio thread ever sees it.
+    std::lock_guard<std::mutex> lock(stateBuildMutex);
+    latestIR = ir;
+    publishState(createState(latestIR));
+}
+
+void ConvolutionEngine::releaseRetiredStates()
+{
+    delete retiredState.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void ConvolutionEngine::setBackgroundTailOptions(const BackgroundTailOptions& options)
+{
+    std::lock_guard<std::mutex> lock(stateBuildMutex);
+    backgroundOptions = options;
+    backgroundOptions.numThreads = std::max(1, options.numThreads);
+
+    // Tier roles are decided when a state is built, so rebuild it for the current IR.
+    if (latestIR)
+        publishState(createState(latestIR));
+}
+
+void ConvolutionEngine::setTailScheduling(TailScheduling scheduling)
+{
+    std::lock_guard<std::mutex> lock(stateBuildMutex);
+    tailScheduling = scheduling;
+
+    if (latestIR)
+        publishState(createState(latestIR));
+}
+
+void ConvolutionEngine::setFftBackend(FftBackend::Kind kind)
+{
+    std::lock_guard<std::mutex> lock(stateBuildMutex);
+    fftBackend = kind;
+
+    if (latestIR)
+        publishState(createState(latestIR));
+}
+
+void ConvolutionEngine::setMix(float wetDry)
+{
+    wetMix = std::clamp(wetDry, 0.0f, 1.0f);
+}
+
+void ConvolutionEngine::setOutputTrim(float db)
+{
+    outputGain = juce::Decibels::decibelsToGain(db);
+}
+
+std::unique_ptr<ConvolutionEngine::State> ConvolutionEngine::createState(const std::shared_ptr<const IRData>& ir)
+{
+    return std::make_unique<State>(ir, preparedChannels.load(), fftBackend, tailScheduling, backgroundOptions,
+                                   tailDeadlineMisses, tailWorkersHeld, cpuMeter);
+}
+
+void ConvolutionEngine::publishState(std::unique_ptr<State> state)
+{
+    partitionSize.store(state->getPartitionSize());
+    latencySamples.store(state->getLatencySamples());
+
+    // A state the audio thread never picked up (e.g. while it was stopped) is still ours to delete.
+    delete pendingState.exchange(state.release(), std::memory_order_acq_rel);
+    releaseRetiredStates();
+}
+
+void ConvolutionEngine::adoptPendingState()
+{
+    // One swap at a time: the running crossfade must finish and the state it retired must have
+    // been collected, so the audio thread never has to free anything itself.
+    if (fadePosition < fadeLength || retiredState.load(std::memory_order_acquire) != nullptr)
+        return;
+
+    State* next = pendingState.exchange(nullptr, std::memory_order_acq_rel);
+    if (next == nullptr)
+        return;
+
+    fadeLength = static_cast<int>(crossfadeSeconds.load() * sampleRate);
+    fadePosition = 0;
+
+    // With a crossfade the old state keeps running until it is silent in the mix. The first IR
+    // fades in from a dry-only output the same way (see processSlice for the dry side).
+    if (fadeLength > 0)
+        fadingState = activeState;
+    else
+        retiredState.store(activeState, std::memory_order_release);
+
+    activeState = next;
+}
+
+void ConvolutionEngine::process(juce::AudioBuffer<float>& buffer)
+{
+    juce::ScopedNoDenormals guard;
+
+    adoptPendingState();
+    if (activeState == nullptr || maxBlockSize == 0)
+        return;
+
+    // Hosts may exceed the prepared block size; slicing keeps every scratch buffer preallocated.
+    const int numChannels = std::min(buffer.getNumChannels(), dryBuffer.getNumChannels());
+    const int numSamples = buffer.getNumSamples();
+    for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+        processSlice(buffer, offset, std::min(maxBlockSize, numSamples - offset), numChannels);
+}
+
+void ConvolutionEngine::processSlice(juce::AudioBuffer<float>& buffer, int offset, int numSamples, int numChannels)
+{
+    const bool fading = fadePosition < fadeLength;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        dryBuffer.copyFrom(ch, 0, buffer, ch, offset, numSamples);
+        if (fading)
+        {
+            fadeBuffer.copyFrom(ch, 0, buffer, ch, offset, numSamples);
+            fadeDryBuffer.copyFrom(ch, 0, buffer, ch, offset, numSamples);
+        }
+
+        activePointers[static_cast<size_t>(ch)] = buffer.getWritePointer(ch) + offset;
+        fadePointers[static_cast<size_t>(ch)] = fadeBuffer.getWritePointer(ch);
+        dryPointers[static_cast<size_t>(ch)] = dryBuffer.getWritePointer(ch);
+        fadeDryPointers[static_cast<size_t>(ch)] = fadeDryBuffer.getWritePointer(ch);
+    }
+
+    // Each state overwrites its channels with the wet signal and its dry buffer with the input
+    // delayed to match. Without a usable state (none yet, or one built for a different channel
+    // count across a prepare) the wet side is silent and the dry side is the undelayed input.
+    const auto isUsable = [numChannels](const State* state)
+    {
+        return state != nullptr && state->getNumChannels() == numChannels;
+    };
+    const auto runState = [&](State* state, juce::AudioBuffer<float>& target, int targetOffset,
+                              float* const* pointers, float* const* dry)
+    {
+        if (isUsable(state))
+            state->process(pointers, dry, numSamples);
+        else
+            for (int ch = 0; ch < numChannels; ++ch)
+                target.clear(ch, targetOffset, numSamples);
+    };
+
+    runState(activeState, buffer, offset, activePointers.data(), dryPointers.data());
+    if (fading)
+        runState(fadingState, fadeBuffer, 0, fadePointers.data(), fadeDryPointers.data());
+
+    // Two dry signals at different latencies (e.g. the undelayed input before the first IR and an
+    // FFT head's FIFO) would comb while they crossfade, so then the dry side switches to the new
+    // state at once and only the wet side fades.
+    const auto getDryLatency = [&](const State* state) { return isUsable(state) ? state->getLatencySamples() : 0; };
+    const bool fadeDry = fading && getDryLatency(fadingState) == getDryLatency(activeState);
+
+    const CpuMeter::ScopedStage mixTime(cpuMeter, CpuMeter::mix);
+    const float dryMix = 1.0f - wetMix;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* samples = buffer.getWritePointer(ch) + offset;
+        const float* dry = dryBuffer.getReadPointer(ch);
+        const float* oldWet = fadeBuffer.getReadPointer(ch);
+        const float* oldDry = fadeDryBuffer.getReadPointer(ch);
+
+        for (int n = 0; n < numSamples; ++n)
+        {
+            float wet = samples[n];
+            float drySample = dry[n];
+            if (fading)
+            {
+                const float gain = std::min(1.0f, static_cast<float>(fadePosition + n) / static_cast<float>(fadeLength));
+                wet = gain * wet + (1.0f - gain) * oldWet[n];
+                if (fadeDry)
+                    drySample = gain * drySample + (1.0f - gain) * oldDry[n];
+            }
+            samples[n] = outputGain * (wetMix * wet + dryMix * drySample);
+        }
+    }
+
+    if (fading)
+    {
+        fadePosition += numSamples;
+        if (fadePosition >= fadeLength)
+        {
+            // adoptPendingState made sure the slot is empty.
+            retiredState.store(fadingState, std::memory_order_release);
+            fadingState = nullptr;
+            fadeLength = fadePosition = 0;
+        }
+    }
+}
+
+//==============================================================================
+ConvolutionEngine::State::State(std::shared_ptr<const IRData> ir, int numChannels, FftBackend::Kind fftKind,
+                                TailScheduling scheduling, const BackgroundTailOptions& options,
+                                std::atomic<int>& deadlineMisses, const std::atomic<bool>& workersHeld, CpuMeter& meter)
+    : irData(std::move(ir)), fftBackend(fftKind), tailScheduling(scheduling), backgroundOptions(options),
+      tailDeadlineMisses(deadlineMisses), tailWorkersHeld(workersHeld), cpuMeter(meter)
+{
+    partitionSize = irData->partitionSize;
+    configureTiers(*irData);
+    allocateChannels(numChannels);
+
+    // The last non-silent sample reaches the output within irLength samples, plus up to one
+    // partition to complete its block, one to finish its work and the wet ring's lookahead.
+    sleepThreshold = static_cast<int64_t>(irData->irLength) + maxFftSize + wetBufferSize;
+    startTailWorkers();
+}
+
+ConvolutionEngine::State::~State()
+{
+    stopTailWorkers();
+}
+
+void ConvolutionEngine::State::reset()
+{
+    // Workers own the background tiers' delay lines, so park them while state is cleared.
+    stopTailWorkers();
+
+    for (auto& ch : wetBuffers)
+        std::fill(ch.begin(), ch.end(), 0.0f);
+    wetReadPosition = 0;
+    for (auto& history : firHistories)
+        std::fill(history.begin(), history.end(), 0.0f);
+    silentRun = 0;
+    asleep = false;
+    for (auto* fifos : { &fifoInput, &fifoOutput, &fifoDry })
+        for (auto& fifo : *fifos)
+            std::fill(fifo.begin(), fifo.end(), 0.0f);
+    fifoFill = 0;
+
+    for (auto& tier : tiers)
+    {
+        tier.inputFill = 0;
+        tier.writePosition = 0;
+        for (auto& channelSpectra : tier.inputSpectra)
+            channelSpectra.clear();
+        for (auto& flags : tier.silentSpectra)
+            std::fill(flags.begin(), flags.end(), uint8_t{ 1 });
+
+        tier.distributedJob.active = false;
+
+        if (tier.jobStream)
+        {
+            for (auto& job : tier.jobStream->slots)
+                job.state.store(jobIdle, std::memory_order_relaxed);
+            tier.jobStream->submitted = tier.jobStream->collected = tier.jobStream->processed = 0;
+            tier.jobStream->pendingSkips = 0;
+        }
+    }
+
+    startTailWorkers();
+}
+
+void ConvolutionEngine::State::process(float* const* channels, float* const* dry, int numSamples)
+{
+    if (directLength > 0)
+    {
+        // The direct FIR covers the head as samples arrive and every tier gathers whole blocks, so
+        // any chunking works without latency; the dry signal needs no delay.
+        int processed = 0;
+        while (processed < numSamples)
+        {
+            const int chunkSize = std::min(partitionSize, numSamples - processed);
+            processChunkOrSleep(channels, processed, chunkSize);
+            processed += chunkSize;
+        }
+        return;
+    }
+
+    // FFT head: queue input until a whole partition is available, then run every tier on it once.
+    // Each sample is read into the FIFO before the result from one partition earlier replaces it.
+    int processed = 0;
+    while (processed < numSamples)
+    {
+        const int count = std::min(numSamples - processed, partitionSize - fifoFill);
+        for (int ch = 0; ch < allocatedChannels; ++ch)
+        {
+            const auto c = static_cast<size_t>(ch);
+            std::copy(channels[ch] + processed, channels[ch] + processed + count, fifoInput[c].begin() + fifoFill);
+            std::copy(fifoOutput[c].begin() + fifoFill, fifoOutput[c].begin() + fifoFill + count, channels[ch] + processed);
+            std::copy(fifoDry[c].begin() + fifoFill, fifoDry[c].begin() + fifoFill + count, dry[ch] + processed);
+        }
+
+        fifoFill += count;
+        processed += count;
+
+        if (fifoFill == partitionSize)
+        {
+            for (int ch = 0; ch < allocatedChannels; ++ch)
+                fifoDry[static_cast<size_t>(ch)] = fifoInput[static_cast<size_t>(ch)];
+
+            processChunkOrSleep(fifoPointers.data(), 0, partitionSize);
+
+            for (int ch = 0; ch < allocatedChannels; ++ch)
+                fifoOutput[static_cast<size_t>(ch)] = fifoInput[static_cast<size_t>(ch)];
+            fifoFill = 0;
+        }
+    }
+}
+
+void ConvolutionEngine::State::processChunkOrSleep(float* const* channels, int chunkOffset, int chunkSize)
+{
+    bool chunkSilent = true;
+    for (int ch = 0; ch < allocatedChannels && chunkSilent; ++ch)
+        chunkSilent = isSilent(channels[ch] + chunkOffset, chunkSize);
+    silentRun = chunkSilent ? silentRun + chunkSize : 0;
+
+    if (asleep && chunkSilent)
+    {
+        for (int ch = 0; ch < allocatedChannels; ++ch)
+            std::fill(channels[ch] + chunkOffset, channels[ch] + chunkOffset + chunkSize, 0.0f);
+        return;
+    }
+
+    processChunk(*irData, channels, chunkOffset, chunkSize);
+    asleep = silentRun >= sleepThreshold;
+}
+
+void ConvolutionEngine::State::configureTiers(const IRData& ir)
+{
+    tiers.clear();
+    tiers.resize(ir.tiers.size());
+
+    irLayout = ir.layout;
+    irPaths = std::max(1, ir.numChannels);
+    directLength = ir.directLength;
+    firOutput.assign(static_cast<size_t>(ir.partitionSize), 0.0f);
+
+    maxFftSize = 0;
+    int wetSpan = 2 * ir.partitionSize;
+    for (size_t t = 0; t < ir.tiers.size(); ++t)
+    {
+        const auto& source = ir.tiers[t];
+        auto& tier = tiers[t];
+        tier.fft = FftBackend::get(fftBackend, source.fftOrder);
+        tier.compactMac = ComplexMac::getCompactMultiKernel(source.format);
+        tier.partitionSize = source.partitionSize;
+        tier.fftSize = source.fftSize;
+        tier.numPartitions = std::max(1, source.numPartitions);
+        tier.irOffset = source.irOffset;
+        // Only tiers whose segment starts a full period after their block completes can wait for a worker.
+        tier.background = backgroundOptions.enabled && t > 0
+                          && source.partitionSize >= backgroundOptions.minPartitionSize
+                          && source.irOffset >= 2 * source.partitionSize;
+        tier.distributed = !tier.background && t > 0 && tailScheduling == TailScheduling::distributed
+                           && source.irOffset >= 2 * source.partitionSize;
+        // A real FFT of size N costs roughly (5/16) * log2(N) times one partition's complex MAC.
+        tier.fftCostUnits = std::max(1, source.fftOrder * 5 / 16);
+
+        maxFftSize = std::max(maxFftSize, source.fftSize);
+        // A gathered block completes at most one head chunk into the current output and lands
+        // irOffset - partitionSize later, spanning fftSize samples.
+        wetSpan = std::max(wetSpan, ir.partitionSize + source.irOffset + source.partitionSize);
+    }
+
+    wetBufferSize = juce::nextPowerOfTwo(wetSpan);
+}
+
+void ConvolutionEngine::State::buildRoutes(int numChannels)
+{
+    // Each output lists the (input, path) pairs that feed it. Input spectra are computed once per
+    // channel whatever the layout, so a true-stereo IR only adds MACs. The same routes grouped by
+    // path drive the fused MAC: a mono IR on a stereo bus is one path with two routes.
+    routes.assign(static_cast<size_t>(numChannels), {});
+    pathRoutes.assign(static_cast<size_t>(irPaths), {});
+    numRoutes = 0;
+    for (int output = 0; output < numChannels; ++output)
+    {
+        auto& outputRoutes = routes[static_cast<size_t>(output)];
+        if (irLayout == IRData::Layout::trueStereo)
+        {
+            for (int input = 0; input < std::min(numChannels, 2); ++input)
+                outputRoutes.push_back({ input, input * 2 + std::min(output, 1), output });
+        }
+        else
+        {
+            outputRoutes.push_back({ output, std::min(output, irPaths - 1), output });
+        }
+
+        for (const auto& route : outputRoutes)
+            pathRoutes[static_cast<size_t>(route.path)].push_back(route);
+        numRoutes += static_cast<int>(outputRoutes.size());
+    }
+}
+
+void ConvolutionEngine::State::allocateChannels(int numChannels)
+{
+    allocatedChannels = std::max(1, numChannels);
+    const auto channels = static_cast<size_t>(allocatedChannels);
+    int workerCursor = 0;
+
+    wetBuffers.assign(channels, std::vector<float>(static_cast<size_t>(wetBufferSize), 0.0f));
+    wetReadPosition = 0;
+    firHistories.assign(directLength > 0 ? channels : 0,
+                        std::vector<float>(static_cast<size_t>(directLength - 1 + partitionSize), 0.0f));
+    chunkPointers.assign(channels, nullptr);
+
+    const auto fifoSize = static_cast<size_t>(directLength > 0 ? 0 : partitionSize);
+    fifoInput.assign(channels, std::vector<float>(fifoSize, 0.0f));
+    fifoOutput.assign(channels, std::vector<float>(fifoSize, 0.0f));
+    fifoDry.assign(channels, std::vector<float>(fifoSize, 0.0f));
+    fifoPointers.clear();
+    for (auto& fifo : fifoInput)
+        fifoPointers.push_back(fifo.data());
+    fifoFill = 0;
+    buildRoutes(allocatedChannels);
+    scratch.allocate(maxFftSize, allocatedChannels);
+
+    for (auto& tier : tiers)
+    {
+        tier.inputBlocks.assign(channels, std::vector<float>(static_cast<size_t>(tier.partitionSize), 0.0f));
+        tier.inputBlockPointers.clear();
+        for (const auto& block : tier.inputBlocks)
+            tier.inputBlockPointers.push_back(block.data());
+        tier.inputFill = 0;
+        tier.writePosition = 0;
+
+        tier.inputSpectra.clear();
+        tier.inputSpectra.reserve(channels);
+        for (size_t ch = 0; ch < channels; ++ch)
+            tier.inputSpectra.emplace_back(tier.numPartitions, tier.fftSize / 2 + 1);
+        tier.silentSpectra.assign(channels, std::vector<uint8_t>(static_cast<size_t>(tier.numPartitions), 1));
+
+        tier.distributedJob = {};
+        if (tier.distributed)
+        {
+            tier.distributedJob.inputs.assign(channels, std::vector<float>(static_cast<size_t>(tier.partitionSize), 0.0f));
+            tier.distributedJob.accum.allocate(allocatedChannels, tier.fftSize / 2 + 1);
+            tier.distributedJob.outputActive.assign(channels, 0);
+        }
+
+        tier.jobStream.reset();
+        if (tier.background)
+        {
+            tier.jobStream = std::make_unique<TailJobStream>();
+            tier.jobStream->workerIndex = workerCursor++ % backgroundOptions.numThreads;
+            for (auto& job : tier.jobStream->slots)
+            {
+                job.inputs.assign(channels, std::vector<float>(static_cast<size_t>(tier.partitionSize), 0.0f));
+                job.outputs.assign(channels, std::vector<float>(static_cast<size_t>(tier.fftSize), 0.0f));
+                job.outputSilent.assign(channels, 1);
+            }
+        }
+    }
+}
+
+void ConvolutionEngine::State::processChunk(const IRData& ir, float* const* channels, int chunkOffset, int chunkSize)
+{
+    for (int ch = 0; ch < allocatedChannels; ++ch)
+        chunkPointers[static_cast<size_t>(ch)] = channels[ch] + chunkOffset;
+
+    // The head adds no latency: either the direct FIR covers the first IR samples, or the head
+    // tier transforms every chunk straight away.
+    size_t firstGatheredTier = 0;
+    if (directLength > 0)
+        processDirectHead(ir, chunkSize);
+    else
+    {
+        processTierBlock(ir, 0, chunkPointers.data(), chunkSize, 0);
+        firstGatheredTier = 1;
+    }
+
+    // The other tiers gather input until a full partition is available. Their IR segments start
+    // at least one partition in, so each result lands at or after the current output position.
+    for (size_t t = firstGatheredTier; t < tiers.size(); ++t)
+    {
+        auto& tier = tiers[t];
+
+        int consumed = 0;
+        int samplesSinceCompletion = chunkSize;
+        while (consumed < chunkSize)
+        {
+            const int count = std::min(chunkSize - consumed, tier.partitionSize - tier.inputFill);
+            for (int ch = 0; ch < allocatedChannels; ++ch)
+            {
+                const float* input = chunkPointers[static_cast<size_t>(ch)] + consumed;
+                std::copy(input, input + count, tier.inputBlocks[static_cast<size_t>(ch)].begin() + tier.inputFill);
+            }
+            tier.inputFill += count;
+            consumed += count;
+
+            if (tier.inputFill == tier.partitionSize)
+            {
+                const int outputOffset = consumed - tier.partitionSize + tier.irOffset;
+                if (tier.background)
+                    handOffTierBlock(static_cast<int>(t), outputOffset);
+                else if (tier.distributed)
+                    startDistributedJob(ir, static_cast<int>(t), outputOffset);
+                else
+                    processTierBlock(ir, static_cast<int>(t), tier.inputBlockPointers.data(), tier.partitionSize, outputOffset);
+                tier.inputFill = 0;
+                samplesSinceCompletion = chunkSize - consumed;
+            }
+        }
+
+        if (tier.distributed)
+            advanceDistributedJob(ir, static_cast<int>(t), samplesSinceCompletion);
+    }
+
+    // Emit this chunk from the wet ring and clear what was read so later blocks can add into it.
+    const int mask = wetBufferSize - 1;
+
+    for (int ch = 0; ch < allocatedChannels; ++ch)
+    {
+        auto& wet = wetBuffers[static_cast<size_t>(ch)];
+        float* samples = channels[ch] + chunkOffset;
+
+        for (int n = 0; n < chunkSize; ++n)
+        {
+            auto& w = wet[static_cast<size_t>((wetReadPosition + n) & mask)];
+            samples[n] = w;
+            w = 0.0f;
+        }
+    }
+
+    wetReadPosition = (wetReadPosition + chunkSize) & mask;
+}
+
+void ConvolutionEngine::State::processDirectHead(const IRData& ir, int numSamples)
+{
+    // Each history keeps the last directLength - 1 inputs in front of the new chunk, so the FIR
+    // never wraps; afterwards the newest samples are slid down for the next chunk.
+    const CpuMeter::ScopedStage firTime(cpuMeter, CpuMeter::fir);
+    const int keep = directLength - 1;
+
+    for (int ch = 0; ch < allocatedChannels; ++ch)
+    {
+        const float* input = chunkPointers[static_cast<size_t>(ch)];
+        std::copy(input, input + numSamples, firHistories[static_cast<size_t>(ch)].begin() + keep);
+    }
+
+    for (int output = 0; output < allocatedChannels; ++output)
+    {
+        for (const auto& route : routes[static_cast<size_t>(output)])
+        {
+            firKernel(firOutput.data(), firHistories[static_cast<size_t>(route.input)].data(),
+                      ir.directTaps[static_cast<size_t>(route.path)].data(), directLength, numSamples);
+            addToWet(output, wetReadPosition, firOutput.data(), numSamples);
+        }
+    }
+
+    for (auto& history : firHistories)
+        std::copy(history.begin() + numSamples, history.begin() + numSamples + keep, history.begin());
+}
+
+void ConvolutionEngine::State::processTierBlock(const IRData& ir, int tierIndex, const float* const* blocks,
+                                         int blockLength, int outputOffset)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+
+    advanceTierDelayLine(tier);
+    {
+        const CpuMeter::ScopedStage fftTime(cpuMeter, CpuMeter::fft);
+        for (int ch = 0; ch < allocatedChannels; ++ch)
+            transformTierInput(tierIndex, ch, blocks[ch], blockLength, scratch);
+    }
+
+    {
+        const CpuMeter::ScopedStage macTime(cpuMeter, CpuMeter::mac);
+        convolveTier(ir, tierIndex, scratch);
+    }
+
+    // Outputs whose slots were all silent have nothing to transform back.
+    const CpuMeter::ScopedStage ifftTime(cpuMeter, CpuMeter::ifft);
+    const int wetPosition = (wetReadPosition + outputOffset) & (wetBufferSize - 1);
+    for (int output = 0; output < allocatedChannels; ++output)
+        if (scratch.outputActive[static_cast<size_t>(output)])
+            addToWet(output, wetPosition, inverseTransformTier(tierIndex, scratch.accumSpectrum, output, scratch),
+                     tier.fftSize);
+}
+
+void ConvolutionEngine::State::advanceTierDelayLine(TierState& tier)
+{
+    // The rings run backwards: the newest spectrum goes one slot below the previous one, so
+    // partition p reads slot writePos + p and the MAC walks both X and H in increasing address order.
+    tier.writePosition = (tier.writePosition == 0 ? tier.numPartitions : tier.writePosition) - 1;
+}
+
+void ConvolutionEngine::State::transformTierInput(int tierIndex, int channel, const float* block, int blockLength,
+                                           FFTScratch& work)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+
+    // A silent block only needs its flag: the MAC skips the slot, so its spectrum is never read.
+    auto& silent = tier.silentSpectra[static_cast<size_t>(channel)][static_cast<size_t>(tier.writePosition)];
+    silent = isSilent(block, blockLength) ? 1 : 0;
+    if (silent)
+        return;
+
+    // Transform the zero-padded block straight into the slot advanceTierDelayLine opened.
+    auto& spectra = tier.inputSpectra[static_cast<size_t>(channel)];
+    tier.fft->forward(block, blockLength, spectra.real(tier.writePosition), spectra.imag(tier.writePosition),
+                      work.fftWork.data());
+}
+
+void ConvolutionEngine::State::accumulateTierPartitions(const IRData& ir, int tierIndex,
+                                                 int firstPartition, int endPartition,
+                                                 SpectrumBuffer& accum, uint8_t* outputActive)
+{
+    // Accumulate frequency response across this tier's IR partitions (overlap-add in frequency domain)
+    // into every output's accumulator. Partitions are walked once: each IR path's spectrum feeds all
+    // routes reading it in one fused call, so a partition leaves memory once per block rather than
+    // once per output. Padding bins are zero in every spectrum, so the kernel runs over the whole
+    // stride and never needs a scalar tail. Slots holding silent blocks are skipped, and so are IR
+    // partitions a progressive load has not filled in yet; outputs that received a MAC are flagged
+    // in outputActive.
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+    const auto& irTier = ir.tiers[static_cast<size_t>(tierIndex)];
+    const int writePos = tier.writePosition;
+    const int lastPartition = std::min(endPartition, ir.getReadyPartitions(tierIndex));
+    const int macCount = tier.inputSpectra.front().getStride();
+    std::array<ComplexMac::Lane, maxFusedRoutes> lanes;
+
+    for (int p = firstPartition; p < lastPartition; ++p)
+    {
+        const int idx = writePos + p;
+        const int inputIndex = (idx >= tier.numPartitions ? idx - tier.numPartitions : idx);
+
+        for (size_t path = 0; path < pathRoutes.size(); ++path)
+        {
+            const auto runLanes = [&](int numLanes)
+            {
+                if (tier.compactMac != nullptr)
+                {
+                    // The compact stride is at least the float stride, so macCount stays in bounds.
+                    const auto& irSpectra = irTier.compactSpectra[path];
+                    tier.compactMac(lanes.data(), numLanes, irSpectra.real(p), irSpectra.imag(p),
+                                    irTier.compactScales[path][static_cast<size_t>(p)], macCount);
+                }
+                else
+                {
+                    const auto& irSpectra = irTier.spectra[path];
+                    macKernel(lanes.data(), numLanes, irSpectra.real(p), irSpectra.imag(p), macCount);
+                }
+            };
+
+            int numLanes = 0;
+            for (const auto& route : pathRoutes[path])
+            {
+                if (tier.silentSpectra[static_cast<size_t>(route.input)][static_cast<size_t>(inputIndex)])
+                    continue;
+
+                const auto& channelSpectra = tier.inputSpectra[static_cast<size_t>(route.input)];
+                lanes[static_cast<size_t>(numLanes++)] = { accum.real(route.output), accum.imag(route.output),
+                                                           channelSpectra.real(inputIndex), channelSpectra.imag(inputIndex) };
+                outputActive[route.output] = 1;
+
+                if (numLanes == maxFusedRoutes)
+                {
+                    runLanes(numLanes);
+                    numLanes = 0;
+                }
+            }
+
+            if (numLanes > 0)
+                runLanes(numLanes);
+        }
+    }
+}
+
+const float* ConvolutionEngine::State::inverseTransformTier(int tierIndex, const SpectrumBuffer& accum, int accumIndex,
+                                                     FFTScratch& work)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+
+    // IFFT back to time domain; every backend's inverse is already scaled by 1/fftSize.
+    // The whole linear convolution (block + segment - 1 samples) fits in the fftSize samples.
+    tier.fft->inverse(accum.real(accumIndex), accum.imag(accumIndex), work.timeDomain.data(), work.fftWork.data());
+    return work.timeDomain.data();
+}
+
+void ConvolutionEngine::State::convolveTier(const IRData& ir, int tierIndex, FFTScratch& work)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+
+    // Only this tier's stride of each output's accumulator is used (and needs clearing).
+    const int stride = tier.inputSpectra.front().getStride();
+    for (int output = 0; output < allocatedChannels; ++output)
+    {
+        std::fill(work.accumSpectrum.real(output), work.accumSpectrum.real(output) + stride, 0.0f);
+        std::fill(work.accumSpectrum.imag(output), work.accumSpectrum.imag(output) + stride, 0.0f);
+    }
+    std::fill(work.outputActive.begin(), work.outputActive.end(), uint8_t{ 0 });
+
+    accumulateTierPartitions(ir, tierIndex, 0, tier.numPartitions, work.accumSpectrum, work.outputActive.data());
+}
+
+void ConvolutionEngine::State::startDistributedJob(const IRData& ir, int tierIndex, int outputOffset)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+    auto& job = tier.distributedJob;
+
+    // The previous block normally finished on the last callback of its period; this only runs
+    // leftover steps when uneven host blocks left it short.
+    if (job.active)
+        advanceDistributedJob(ir, tierIndex, tier.partitionSize);
+
+    for (int ch = 0; ch < allocatedChannels; ++ch)
+        std::copy(tier.inputBlocks[static_cast<size_t>(ch)].begin(), tier.inputBlocks[static_cast<size_t>(ch)].end(),
+                  job.inputs[static_cast<size_t>(ch)].begin());
+    job.accum.clear();
+    std::fill(job.outputActive.begin(), job.outputActive.end(), uint8_t{ 0 });
+    job.wetPosition = (wetReadPosition + outputOffset) & (wetBufferSize - 1);
+    job.elapsed = 0;
+    job.nextStep = 0;
+    job.unitsDone = 0;
+    job.active = true;
+}
+
+void ConvolutionEngine::State::advanceDistributedJob(const IRData& ir, int tierIndex, int numSamples)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+    auto& job = tier.distributedJob;
+    if (!job.active)
+        return;
+
+    // Steps: [0, firstMac) forward FFTs, one per input; [firstMac, firstInverse) one fused MAC pass
+    // per partition, costing one unit per route; [firstInverse, lastStep) inverse FFTs.
+    const int numChannels = allocatedChannels;
+    const int firstMac = numChannels;
+    const int firstInverse = firstMac + tier.numPartitions;
+    const int lastStep = firstInverse + numChannels;
+    const int unitsPerPartition = std::max(1, numRoutes);
+    const int totalUnits = unitsPerPartition * tier.numPartitions + 2 * numChannels * tier.fftCostUnits;
+
+    // Keep the work done proportional to the time elapsed in the partition period, so the job is
+    // complete by the time the next block arrives (its result is due one period after that).
+    job.elapsed = std::min(tier.partitionSize, job.elapsed + numSamples);
+    const int targetUnits = static_cast<int>(static_cast<int64_t>(totalUnits) * job.elapsed / tier.partitionSize);
+
+    while (job.active && job.unitsDone < targetUnits)
+    {
+        if (job.nextStep < firstMac)
+        {
+            const CpuMeter::ScopedStage fftTime(cpuMeter, CpuMeter::fft);
+            if (job.nextStep == 0)
+                advanceTierDelayLine(tier);
+
+            transformTierInput(tierIndex, job.nextStep, job.inputs[static_cast<size_t>(job.nextStep)].data(),
+                               tier.partitionSize, scratch);
+            job.unitsDone += tier.fftCostUnits;
+            ++job.nextStep;
+        }
+        else if (job.nextStep < firstInverse)
+        {
+            // Run as many partitions as the budget allows in one pass.
+            const CpuMeter::ScopedStage macTime(cpuMeter, CpuMeter::mac);
+            const int first = job.nextStep - firstMac;
+            const int count = std::max(1, std::min((targetUnits - job.unitsDone) / unitsPerPartition,
+                                                   tier.numPartitions - first));
+            accumulateTierPartitions(ir, tierIndex, first, first + count, job.accum, job.outputActive.data());
+            job.unitsDone += count * unitsPerPartition;
+            job.nextStep += count;
+        }
+        else
+        {
+            const CpuMeter::ScopedStage ifftTime(cpuMeter, CpuMeter::ifft);
+            const int output = job.nextStep - firstInverse;
+            if (job.outputActive[static_cast<size_t>(output)])
+                addToWet(output, job.wetPosition, inverseTransformTier(tierIndex, job.accum, output, scratch), tier.fftSize);
+            job.unitsDone += tier.fftCostUnits;
+            job.active = ++job.nextStep < lastStep;
+        }
+    }
+}
+
+void ConvolutionEngine::State::addToWet(int channel, int wetPosition, const float* samples, int numSamples)
+{
+    // Results are added where their IR segment starts, relative to the output they were computed for.
+    auto& wet = wetBuffers[static_cast<size_t>(channel)];
+    const int mask = wetBufferSize - 1;
+    for (int i = 0; i < numSamples; ++i)
+        wet[static_cast<size_t>((wetPosition + i) & mask)] += samples[i];
+}
+
+void ConvolutionEngine::State::handOffTierBlock(int tierIndex, int outputOffset)
+{
+    auto& tier = tiers[static_cast<size_t>(tierIndex)];
+    auto& stream = *tier.jobStream;
+
+    // Collect the previous block's result. It lands at least one partition ahead of the current
+    // output, so anything finished by now is still in time; anything unfinished is a miss.
+    while (stream.collected != stream.submitted)
+    {
+        auto& job = stream.slots[stream.collected % TailJobStream::numSlots];
+        int state = job.state.load(std::memory_order_acquire);
+
+        if (state == jobPending
+            && job.state.compare_exchange_strong(state, jobAbandoned, std::memory_order_acq_rel))
+        {
+            tailDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            for (int output = 0; output < allocatedChannels; ++output)
+                if (!job.outputSilent[static_cast<size_t>(output)])
+                    addToWet(output, job.wetPosition, job.outputs[static_cast<size_t>(output)].data(), tier.fftSize);
+            job.state.store(jobIdle, std::memory_order_release);
+        }
+
+        ++stream.collected;
+    }
+
+    // Submit this block. If the worker is a whole ring of blocks behind, drop it rather than wait.
+    // The worker still has to advance its delay lines for it, or every later block would meet the
+    // IR partitions one slot off; the next job carries the count. Past a whole delay line of them
+    // the result (an empty ring) is the same, so the count stops there.
+    auto& job = stream.slots[stream.submitted % TailJobStream::numSlots];
+    if (job.state.load(std::memory_order_acquire) != jobIdle)
+    {
+        tailDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+        stream.pendingSkips = std::min(stream.pendingSkips + 1, tier.numPartitions);
+        return;
+    }
+
+    for (int ch = 0; ch < allocatedChannels; ++ch)
+        std::copy(tier.inputBlocks[static_cast<size_t>(ch)].begin(), tier.inputBlocks[static_cast<size_t>(ch)].end(),
+                  job.inputs[static_cast<size_t>(ch)].begin());
+    job.wetPosition = (wetReadPosition + outputOffset) & (wetBufferSize - 1);
+    job.skippedBefore = stream.pendingSkips;
+    stream.pendingSkips = 0;
+    job.state.store(jobPending, std::memory_order_release);
+    ++stream.submitted;
+    tailWorkers[static_cast<size_t>(stream.workerIndex)]->wake();
+}
+
+void ConvolutionEngine::State::runTailJobs(int workerIndex, FFTScratch& work)
+{
+    const auto& ir = *irData;
+
+    for (size_t t = 0; t < tiers.size(); ++t)
+    {
+        auto& tier = tiers[t];
+        if (!tier.jobStream || tier.jobStream->workerIndex != workerIndex)
+            continue;
+
+        auto& stream = *tier.jobStream;
+        const int tierIndex = static_cast<int>(t);
+
+        // Jobs are run strictly in submission order so the tier's delay lines stay consistent,
+        // including ones the audio thread has already given up on.
+        for (;;)
+        {
+            auto& job = stream.slots[stream.processed % TailJobStream::numSlots];
+            const int state = job.state.load(std::memory_order_acquire);
+            if (state != jobPending && state != jobAbandoned)
+                break;
+
+            // Blocks dropped before this one enter the delay lines as silence.
+            for (int skip = 0; skip < job.skippedBefore; ++skip)
+            {
+                advanceTierDelayLine(tier);
+                for (auto& flags : tier.silentSpectra)
+                    flags[static_cast<size_t>(tier.writePosition)] = 1;
+            }
+
+            advanceTierDelayLine(tier);
+            for (size_t ch = 0; ch < job.inputs.size(); ++ch)
+                transformTierInput(tierIndex, static_cast<int>(ch), job.inputs[ch].data(), tier.partitionSize, work);
+
+            convolveTier(ir, tierIndex, work);
+            for (size_t output = 0; output < job.outputs.size(); ++output)
+            {
+                job.outputSilent[output] = work.outputActive[output] ? 0 : 1;
+                if (work.outputActive[output])
+                {
+                    const float* result = inverseTransformTier(tierIndex, work.accumSpectrum, static_cast<int>(output), work);
+                    std::copy(result, result + tier.fftSize, job.outputs[output].begin());
+                }
+            }
+
+            int expected = jobPending;
+            if (!job.state.compare_exchange_strong(expected, jobDone, std::memory_order_acq_rel))
+                job.state.store(jobIdle, std::memory_order_release);
+
+            ++stream.processed;
+        }
+    }
+}
+
+void ConvolutionEngine::State::startTailWorkers()
+{
+    if (!tailWorkers.empty())
+        return;
+
+    const bool anyBackground = std::any_of(tiers.begin(), tiers.end(),
+                                           [](const TierState& tier) { return tier.background; });
+    if (!anyBackground)
+        return;
+
+    for (int i = 0; i < backgroundOptions.numThreads; ++i)
+    {
+        auto worker = std::make_unique<TailWorker>(*this, i, maxFftSize, allocatedChannels);
+        if (backgroundOptions.affinityMask != 0)
+            worker->setAffinityMask(backgroundOptions.affinityMask);
+
+        if (backgroundOptions.realtimePriority >= 0)
+            worker->startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(backgroundOptions.realtimePriority));
+        else
+            worker->startThread(juce::Thread::Priority::high);
+
+        tailWorkers.push_back(std::move(worker));
+    }
+}
+
+void ConvolutionEngine::State::stopTailWorkers()
+{
+    for (auto& worker : tailWorkers)
+        worker->signalThreadShouldExit();
+
+    tailWorkers.clear(); // each worker joins in its destructor
+}
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <juce_dsp/juce_dsp.h>
+#include "SpectrumBuffer.h"
+#include "ComplexMac.h"
+#include "DirectFir.h"
+#include "CpuMeter.h"
+#include "FftBackend.h"
+
+// One uniform partitioning of a contiguous IR segment. Tiers get larger towards the tail so
+// the head stays low-latency while the long tail costs few, large FFT partitions.
+struct IRPartitionTier
+{
+    int partitionSize = 0;
+    int fftOrder = 11;
+    int fftSize = 2048; // fftSize = 2 * partitionSize
+    int numPartitions = 0;
+    int irOffset = 0;   // first IR sample covered by this tier (>= 2 * partitionSize for all but the first)
+    int firstPartition = 0; // index of this tier's first partition counted over all tiers, head first
+    // spectra[path] -> numPartitions half spectra (fftSize / 2 + 1 bins), split real/imag
+    std::vector<SpectrumBuffer> spectra;
+
+    // Tail tiers may instead keep their spectra as fp16/bf16 (IRLoader::setSpectrumFormat): then
+    // `spectra` is empty and partition p of a path is decode(compactSpectra[path]) * compactScales[path][p].
+    ComplexMac::SpectrumFormat format = ComplexMac::SpectrumFormat::fp32;
+    std::vector<CompactSpectrumBuffer> compactSpectra;
+    std::vector<std::vector<float>> compactScales;
+};
+
+struct IRData
+{
+    // How the IR's paths map host inputs to outputs. `perChannel` applies path min(channel, numChannels - 1)
+    // to each channel on its own (mono or plain stereo IRs); `trueStereo` holds four paths in the
+    // order LL, LR, RL, RR (input -> output), so each output sums both inputs.
+    enum class Layout
+    {
+        perChannel,
+        trueStereo
+    };
+
+    int partitionSize = 0; // head tier partition size, i.e. the engine's processing granularity
+    int numChannels = 1;   // number of IR paths
+    Layout layout = Layout::perChannel;
+    int irLength = 0;
+
+    // Leading IR samples convolved in the time domain as they arrive, so they add no latency.
+    // When non-zero the FFT tiers start at directLength; when it covers the whole IR there are none.
+    int directLength = 0;
+    std::vector<std::vector<float>> directTaps; // per path, directLength taps in reverse order
+
+    std::vector<IRPartitionTier> tiers; // ordered head -> tail
+
+    // Partitions, counted over all tiers head first, whose spectra are final for every path. A
+    // progressively loaded IR (IRLoader::setProgressiveLoading) is handed out with only its head
+    // ready; the loader fills the rest in order and raises the count with release stores, so the
+    // audio thread reads a partition only once it is complete. Never decreases.
+    std::atomic<int> readyPartitions{ 0 };
+    int totalPartitions = 0;
+
+    int getReadyPartitions(int tierIndex) const noexcept
+    {
+        const auto& tier = tiers[static_cast<size_t>(tierIndex)];
+        return std::clamp(readyPartitions.load(std::memory_order_acquire) - tier.firstPartition, 0, tier.numPartitions);
+    }
+    bool isComplete() const noexcept { return readyPartitions.load(std::memory_order_acquire) >= totalPartitions; }
+
+    // Set when the tiers' spectra are attached to a memory-mapped cache file (IRSpectraFile)
+    // rather than owned; keeps the mapping alive for as long as the IR is in use.
+    std::shared_ptr<const void> externalStorage;
+};
+
+class ConvolutionEngine
+{
+public:
+    // Optional mode where the large tail tiers are convolved by worker threads. A tail tier has a
+    // whole partition period between its block completing and its output being due; results that
+    // are still missing when the next block completes are dropped and counted, never waited for.
+    // A worker that falls a whole ring of blocks behind has the newest blocks dropped as well; it
+    // feeds them to its delay lines as silence, so once it catches up later blocks are exact again.
+    struct BackgroundTailOptions
+    {
+        bool enabled = false;
+        int numThreads = 1;
+        int minPartitionSize = 2048;   // tiers with partitions at least this large leave the audio thread
+        int realtimePriority = 8;      // juce realtime priority 0..10; negative starts a normal high-priority thread
+        juce::uint32 affinityMask = 0; // CPUs the workers may run on; 0 leaves placement to the OS
+    };
+
+    // How tail tiers that stay on the audio thread are scheduled. `immediate` runs a tier's whole
+    // FFT/MAC/IFFT in the callback where its block completes; `distributed` spreads that work
+    // evenly over the callbacks of the following partition period, flattening per-block CPU.
+    enum class TailScheduling
+    {
+        immediate,
+        distributed
+    };
+
+    ConvolutionEngine();
+    ~ConvolutionEngine();
+
+    // prepare/reset (and the tail option setters) expect audio to be stopped.
+    void prepare(double sampleRate, int blockSize, int numChannels);
+    void reset();
+
+    // Safe to call from any non-audio thread while audio runs: the new IR's state is built on the
+    // calling thread and the audio thread switches to it with a crossfade at the next block.
+    void setIR(const std::shared_ptr<const IRData>& ir);
+    void setCrossfadeTime(double seconds) { crossfadeSeconds.store(static_cast<float>(std::max(0.0, seconds))); }
+    // Frees states the audio thread has finished with. Call periodically from a non-audio thread.
+    void releaseRetiredStates();
+
+    void setMix(float wetDry);   // 0..1 wet mix
+    void setOutputTrim(float db); // dB trim applied after mix
+
+    void setBackgroundTailOptions(const BackgroundTailOptions& options);
+    void setTailScheduling(TailScheduling scheduling);
+    // Which FFT implementation new states use; starts at FftBackend::getDefaultKind(). All backends
+    // share one spectrum layout and scaling, so IR data from any of them works with any other.
+    void setFftBackend(FftBackend::Kind kind);
+    int getTailDeadlineMisses() const { return tailDeadlineMisses.load(std::memory_order_relaxed); }
+    // Keeps the tail workers from starting jobs while set, as if they were starved of CPU. For
+    // checking how the engine recovers from an overload (EngineAccuracy).
+    void holdTailWorkers(bool shouldHold) { tailWorkersHeld.store(shouldHold, std::memory_order_relaxed); }
+    // Audio-thread time per stage of every callback timed with CpuMeter::ScopedBlock (the
+    // plugin's processBlock); tail worker threads are not included.
+    CpuMeter& getCpuMeter() { return cpuMeter; }
+    const CpuMeter& getCpuMeter() const { return cpuMeter; }
+
+    int getPartitionSize() const { return partitionSize.load(std::memory_order_relaxed); }
+    // One head partition when the head tier is FFT based (its input FIFO), 0 with a direct FIR head.
+    int getLatencySamples() const { return latencySamples.load(std::memory_order_relaxed); }
+
+    void process(juce::AudioBuffer<float>& buffer);
+
+private:
+    // Everything that depends on one IR: its tiers' delay lines, the wet rings, tail workers and
+    // scratch. A State is built and destroyed off the audio thread; while the audio thread owns
+    // it nothing in it allocates.
+    class State
+    {
+    public:
+        State(std::shared_ptr<const IRData> ir, int numChannels, FftBackend::Kind fftKind, TailScheduling scheduling,
+              const BackgroundTailOptions& options, std::atomic<int>& deadlineMisses,
+              const std::atomic<bool>& workersHeld, CpuMeter& meter);
+        ~State();
+
+        void reset();
+        // Replaces numSamples of input in every channel with the wet signal, and writes the input
+        // delayed by the same latency into dry.
+        void process(float* const* channels, float* const* dry, int numSamples);
+
+        const std::shared_ptr<const IRData>& getIR() const { return irData; }
+        int getNumChannels() const { return allocatedChannels; }
+        int getPartitionSize() const { return partitionSize; }
+        int getLatencySamples() const { return directLength > 0 ? 0 : partitionSize; }
+
+    private:
+        class TailWorker;
+
+        // FFT work buffers; the audio thread and every tail worker own one each.
+        struct FFTScratch
+        {
+            std::vector<float> fftWork;    // backend scratch, FftBackend::getWorkSize() of the largest tier
+            std::vector<float> timeDomain; // inverse FFT output, largest fftSize
+            SpectrumBuffer accumSpectrum;  // split accumulator per output, largest tier's bin count
+            std::vector<uint8_t> outputActive; // per output, accumulator received at least one MAC
+
+            void allocate(int maxFftSize, int numOutputs);
+        };
+
+        // Single-producer (audio thread) / single-consumer (one worker) handoff of a tail tier's blocks,
+        // all channels at once. Slot ownership moves through `state`; nothing here ever blocks.
+        enum TailJobState
+        {
+            jobIdle,      // audio thread may fill the slot
+            jobPending,   // submitted, worker has not finished it
+            jobDone,      // result ready for the audio thread
+            jobAbandoned  // audio thread gave up on the result; worker still runs it to keep its FDL intact
+        };
+
+        struct TailJob
+        {
+            std::vector<std::vector<float>> inputs;  // per input channel, partitionSize samples
+            std::vector<std::vector<float>> outputs; // per output channel, fftSize samples of convolved result
+            std::vector<uint8_t> outputSilent;       // per output channel, result is zero and was not computed
+            int wetPosition = 0;                     // wet ring index the results start at
+            int skippedBefore = 0;                   // blocks dropped since the previous job, pushed as silence first
+            std::atomic<int> state{ jobIdle };
+        };
+
+        struct TailJobStream
+        {
+            static constexpr int numSlots = 4;
+            std::array<TailJob, numSlots> slots;
+            uint32_t submitted = 0; // audio thread
+            uint32_t collected = 0; // audio thread
+            uint32_t processed = 0; // worker
+            int pendingSkips = 0;   // audio thread, dropped blocks the next job carries
+            int workerIndex = 0;
+        };
+
+        // A tail block being worked through a slice at a time on the audio thread. Steps are one
+        // forward FFT per input channel, one fused MAC pass per partition covering every route, then
+        // one inverse FFT per output; each step has a cost in units.
+        struct DistributedJob
+        {
+            std::vector<std::vector<float>> inputs; // per input channel, partitionSize samples
+            SpectrumBuffer accum;                   // one split accumulator per output, survives between callbacks
+            std::vector<uint8_t> outputActive;      // per output, accumulator received at least one MAC
+            int wetPosition = 0;                    // wet ring index the results start at
+            int elapsed = 0;                        // samples consumed since the block completed
+            int nextStep = 0;
+            int unitsDone = 0;
+            bool active = false;
+        };
+
+        // Per-tier runtime state: a frequency-domain delay line per input channel plus the input
+        // samples gathered towards the next tier-sized block. All channels advance in lockstep, so
+        // the fill level and the delay line's write slot are shared.
+        struct TierState
+        {
+            std::shared_ptr<const FftBackend> fft;
+            ComplexMac::CompactMultiKernel compactMac = nullptr; // set when the IR tier is fp16/bf16
+            int partitionSize = 0;
+            int fftSize = 0;
+            int numPartitions = 0;
+            int irOffset = 0;
+            bool background = false;  // convolved by a TailWorker instead of the audio thread
+            bool distributed = false; // spread over the callbacks of one partition period
+            int fftCostUnits = 1;     // cost of one FFT measured in partition MACs
+
+            std::vector<std::vector<float>> inputBlocks; // per input channel, partitionSize samples
+            std::vector<const float*> inputBlockPointers;
+            int inputFill = 0;
+            std::vector<SpectrumBuffer> inputSpectra;    // per input channel, ring of numPartitions input half spectra
+            std::vector<std::vector<uint8_t>> silentSpectra; // per input channel, per slot: block was silent, no spectrum stored
+            int writePosition = 0;                       // newest slot of every ring; moves backwards
+            std::unique_ptr<TailJobStream> jobStream;    // background tiers only
+            DistributedJob distributedJob;               // distributed tiers only
+        };
+
+        // One IR path feeding an output channel.
+        struct Route
+        {
+            int input = 0;
+            int path = 0;
+            int output = 0;
+        };
+
+        // Routes reading one IR path are fused into a single MAC call in batches of this many, so
+        // each IR partition is streamed once per block for a whole (up to 7.1) bus.
+        static constexpr int maxFusedRoutes = 8;
+
+        void configureTiers(const IRData& ir);
+        void allocateChannels(int numChannels);
+        void buildRoutes(int numChannels);
+        void processChunkOrSleep(float* const* channels, int chunkOffset, int chunkSize);
+        void processChunk(const IRData& ir, float* const* channels, int chunkOffset, int chunkSize);
+        void processDirectHead(const IRData& ir, int numSamples);
+        void processTierBlock(const IRData& ir, int tierIndex, const float* const* blocks, int blockSize, int outputOffset);
+        void advanceTierDelayLine(TierState& tier);
+        void transformTierInput(int tierIndex, int channel, const float* block, int blockSize, FFTScratch& scratch);
+        void accumulateTierPartitions(const IRData& ir, int tierIndex, int firstPartition, int endPartition,
+                                      SpectrumBuffer& accum, uint8_t* outputActive);
+        const float* inverseTransformTier(int tierIndex, const SpectrumBuffer& accum, int accumIndex, FFTScratch& scratch);
+        void convolveTier(const IRData& ir, int tierIndex, FFTScratch& scratch);
+        void addToWet(int channel, int wetPosition, const float* samples, int numSamples);
+
+        void startDistributedJob(const IRData& ir, int tierIndex, int outputOffset);
+        void advanceDistributedJob(const IRData& ir, int tierIndex, int numSamples);
+        void handOffTierBlock(int tierIndex, int outputOffset);
+        void runTailJobs(int workerIndex, FFTScratch& scratch);
+        void startTailWorkers();
+        void stopTailWorkers();
+
+        const std::shared_ptr<const IRData> irData;
+        int partitionSize = 1024;
+
+        std::vector<TierState> tiers;
+        int directLength = 0;                         // taps of the direct FIR head, 0 when the head tier is FFT based
+        std::vector<std::vector<float>> firHistories; // per channel, directLength - 1 past samples + one chunk
+        std::vector<float> firOutput;                 // one chunk of direct head output
+
+        std::vector<std::vector<float>> wetBuffers;   // per channel, ring of future wet output all tiers add into
+        int wetReadPosition = 0;                      // shared by every channel's ring
+        int wetBufferSize = 0;                        // power of two
+        int allocatedChannels = 0;
+
+        IRData::Layout irLayout = IRData::Layout::perChannel;
+        int irPaths = 1;
+        std::vector<std::vector<Route>> routes;       // per output channel
+        std::vector<std::vector<Route>> pathRoutes;   // per IR path, every route that reads it
+        int numRoutes = 0;
+        std::vector<const float*> chunkPointers;      // per input channel, the current chunk of the host buffer
+
+        // With an FFT head tier, input is queued until a whole head partition is available and the
+        // wet result is played out one partition later, whatever block sizes the host sends.
+        std::vector<std::vector<float>> fifoInput;    // per channel, partitionSize samples; wet after processing
+        std::vector<std::vector<float>> fifoOutput;   // per channel, previous partition's wet output
+        std::vector<std::vector<float>> fifoDry;      // per channel, previous partition's input
+        std::vector<float*> fifoPointers;             // per channel, fifoInput
+        int fifoFill = 0;
+
+        // Once the input has been silent for longer than the IR plus every pipeline delay, all
+        // delay lines and wet rings are empty and chunks are skipped until input returns.
+        int64_t silentRun = 0;                        // consecutive silent input samples, all channels
+        int64_t sleepThreshold = 0;
+        bool asleep = false;
+
+        FFTScratch scratch;                           // audio thread's FFT buffers
+        int maxFftSize = 0;
+        ComplexMac::MultiKernel macKernel = ComplexMac::getMultiKernel();
+        DirectFir::Kernel firKernel = DirectFir::getKernel();
+
+        const FftBackend::Kind fftBackend;
+        const TailScheduling tailScheduling;
+        const BackgroundTailOptions backgroundOptions;
+        std::vector<std::unique_ptr<TailWorker>> tailWorkers;
+        std::atomic<int>& tailDeadlineMisses;
+        const std::atomic<bool>& tailWorkersHeld;
+        CpuMeter& cpuMeter;
+    };
+
+    std::unique_ptr<State> createState(const std::shared_ptr<const IRData>& ir);
+    void publishState(std::unique_ptr<State> state);
+    void adoptPendingState();
+    void processSlice(juce::AudioBuffer<float>& buffer, int offset, int numSamples, int numChannels);
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+    std::atomic<int> preparedChannels{ 2 };
+    std::atomic<int> partitionSize{ 1024 };
+    std::atomic<int> latencySamples{ 0 };
+    float wetMix = 0.5f;
+    float outputGain = 1.0f;
+
+    // State handoff. setIR publishes into pendingState; the audio thread takes it with one atomic
+    // exchange, crossfades from activeState (which becomes fadingState) and finally hands the old
+    // state to retiredState, from where releaseRetiredStates deletes it. A new state is only adopted
+    // once the previous swap has finished and its retired state has been collected.
+    std::atomic<State*> pendingState{ nullptr };
+    State* activeState = nullptr; // audio thread
+    State* fadingState = nullptr; // audio thread
+    std::atomic<State*> retiredState{ nullptr };
+    int fadeLength = 0;           // audio thread, samples of the current crossfade
+    int fadePosition = 0;         // audio thread, 0 when no crossfade is running
+    std::atomic<float> crossfadeSeconds{ 0.05f };
+
+    // Serialises state building between non-audio threads (loader, message thread); never taken
+    // by the audio thread.
+    std::mutex stateBuildMutex;
+    std::shared_ptr<const IRData> latestIR;
+    FftBackend::Kind fftBackend = FftBackend::getDefaultKind();
+    TailScheduling tailScheduling = TailScheduling::distributed;
+    BackgroundTailOptions backgroundOptions;
+    std::atomic<int> tailDeadlineMisses{ 0 };
+    std::atomic<bool> tailWorkersHeld{ false };
+    CpuMeter cpuMeter;
+
+    // Each state returns its wet signal and the dry input delayed by its own latency, so each side
+    // of a crossfade is aligned with its own dry signal. The dry signals themselves are only
+    // crossfaded when both states have the same latency.
+    juce::AudioBuffer<float> dryBuffer;     // active state's delayed dry signal for one slice
+    juce::AudioBuffer<float> fadeBuffer;    // fading state's wet output during a crossfade
+    juce::AudioBuffer<float> fadeDryBuffer; // fading state's delayed dry signal
+    std::vector<float*> activePointers;     // per channel, the current slice of the host buffer
+    std::vector<float*> fadePointers;       // per channel, fadeBuffer
+    std::vector<float*> dryPointers;        // per channel, dryBuffer
+    std::vector<float*> fadeDryPointers;    // per channel, fadeDryBuffer
+};
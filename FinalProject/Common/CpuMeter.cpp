@@ -0,0 +1,93 @@
+#include "CpuMeter.h"
+#include <algorithm>
+#include <vector>
+
+CpuMeter::ScopedBlock::ScopedBlock(CpuMeter& meterToUse, int samples) noexcept
+    : meter(meterToUse), numSamples(samples), start(juce::Time::getHighResolutionTicks())
+{
+    meter.stageTicks.fill(0);
+}
+
+CpuMeter::ScopedBlock::~ScopedBlock()
+{
+    meter.endBlock(numSamples, juce::Time::getHighResolutionTicks() - start);
+}
+
+void CpuMeter::prepare(double sampleRate)
+{
+    ticksPerSample = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()) / sampleRate;
+    for (auto& stage : history)
+        for (auto& value : stage)
+            value.store(0.0f, std::memory_order_relaxed);
+    blocksWritten.store(0, std::memory_order_relaxed);
+    overrunCount.store(0, std::memory_order_relaxed);
+}
+
+void CpuMeter::endBlock(int numSamples, juce::int64 elapsedTicks) noexcept
+{
+    if (numSamples <= 0 || ticksPerSample <= 0.0)
+        return;
+
+    const double toPercent = 100.0 / (ticksPerSample * numSamples);
+    const auto written = blocksWritten.load(std::memory_order_relaxed);
+    const auto slot = static_cast<size_t>(written % historyLength);
+
+    for (size_t s = 0; s < numStages; ++s)
+        history[s][slot].store(static_cast<float>(stageTicks[s] * toPercent), std::memory_order_relaxed);
+
+    const auto totalPercent = static_cast<float>(elapsedTicks * toPercent);
+    history[numStages][slot].store(totalPercent, std::memory_order_relaxed);
+    if (totalPercent > 100.0f)
+        overrunCount.fetch_add(1, std::memory_order_relaxed);
+
+    blocksWritten.store(written + 1, std::memory_order_release);
+}
+
+CpuMeter::Snapshot CpuMeter::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.numBlocks = blocksWritten.load(std::memory_order_acquire);
+    snapshot.overruns = overrunCount.load(std::memory_order_relaxed);
+
+    const auto count = static_cast<size_t>(std::min<int64_t>(snapshot.numBlocks, historyLength));
+    if (count == 0)
+        return snapshot;
+
+    std::vector<float> values(count);
+    const auto summarise = [&](const std::array<std::atomic<float>, historyLength>& ring)
+    {
+        for (size_t i = 0; i < count; ++i)
+            values[i] = ring[i].load(std::memory_order_relaxed);
+
+        Stats stats;
+        double sum = 0.0;
+        for (float v : values)
+            sum += v;
+        stats.mean = static_cast<float>(sum / static_cast<double>(count));
+        stats.max = *std::max_element(values.begin(), values.end());
+
+        const auto p99 = values.begin() + static_cast<std::ptrdiff_t>(std::min(count - 1, count * 99 / 100));
+        std::nth_element(values.begin(), p99, values.end());
+        stats.p99 = *p99;
+        return stats;
+    };
+
+    for (size_t s = 0; s < numStages; ++s)
+        snapshot.stages[s] = summarise(history[s]);
+    snapshot.total = summarise(history[numStages]);
+    return snapshot;
+}
+
+const char* CpuMeter::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case fft:       return "FFT";
+        case mac:       return "MAC";
+        case ifft:      return "IFFT";
+        case fir:       return "FIR";
+        case mix:       return "Mix";
+        case numStages: break;
+    }
+    return "?";
+}
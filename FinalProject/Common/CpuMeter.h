@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <juce_core/juce_core.h>
+
+// Audio-thread CPU accounting with a per-stage breakdown. The audio thread opens a ScopedBlock
+// per callback and ScopedStage around the work it wants attributed; at the end of the callback
+// each stage's time, and the callback's total, is stored as a percentage of the block's duration
+// into a ring of the last historyLength callbacks. Any other thread can read rolling mean, p99
+// and max from it. Callbacks that took longer than their own duration are counted as overruns.
+// Nothing on the audio side locks or allocates; a snapshot copies the ring with relaxed loads, so
+// it may mix in a callback written while it was being read.
+class CpuMeter
+{
+public:
+    enum Stage
+    {
+        fft,  // forward transforms of input blocks
+        mac,  // frequency-domain multiply-accumulate
+        ifft, // inverse transforms and overlap-add into the wet ring
+        fir,  // direct FIR head
+        mix,  // dry/wet mix, trim and crossfade
+        numStages
+    };
+
+    static constexpr int historyLength = 512;
+
+    struct Stats
+    {
+        float mean = 0.0f; // percent of the block duration
+        float p99 = 0.0f;
+        float max = 0.0f;
+    };
+
+    struct Snapshot
+    {
+        Stats total;
+        std::array<Stats, numStages> stages;
+        int64_t numBlocks = 0;
+        int64_t overruns = 0;
+    };
+
+    // Times a whole callback of numSamples samples.
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(CpuMeter& meterToUse, int numSamples) noexcept;
+        ~ScopedBlock();
+
+    private:
+        CpuMeter& meter;
+        const int numSamples;
+        const juce::int64 start;
+    };
+
+    // Attributes the enclosed work to one stage of the current callback.
+    class ScopedStage
+    {
+    public:
+        ScopedStage(CpuMeter& meterToUse, Stage stageToTime) noexcept
+            : meter(meterToUse), stage(stageToTime), start(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedStage() { meter.stageTicks[static_cast<size_t>(stage)] += juce::Time::getHighResolutionTicks() - start; }
+
+    private:
+        CpuMeter& meter;
+        const Stage stage;
+        const juce::int64 start;
+    };
+
+    // Sets the rate block durations are measured against and clears the history. Not while audio runs.
+    void prepare(double sampleRate);
+
+    // Any thread except the audio thread; allocates.
+    Snapshot getSnapshot() const;
+
+    static const char* getStageName(Stage stage);
+
+private:
+    void endBlock(int numSamples, juce::int64 elapsedTicks) noexcept;
+
+    double ticksPerSample = 0.0;
+    std::array<juce::int64, numStages> stageTicks{}; // audio thread only, current callback
+
+    // history[stage][block]; index numStages holds the callback's total.
+    std::array<std::array<std::atomic<float>, historyLength>, numStages + 1> history{};
+    std::atomic<int64_t> blocksWritten{ 0 };
+    std::atomic<int64_t> overrunCount{ 0 };
+};
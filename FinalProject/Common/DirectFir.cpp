@@ -0,0 +1,132 @@
+#include "DirectFir.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+ #define CONVOLUTION_FIR_X86 1
+ #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+ #define CONVOLUTION_FIR_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+ #define CONVOLUTION_FIR_TARGET(isa) __attribute__((target(isa)))
+#else
+ #define CONVOLUTION_FIR_TARGET(isa)
+#endif
+
+namespace DirectFir
+{
+namespace
+{
+    inline void firScalarTail(float* out, const float* history, const float* reversedTaps,
+                              int numTaps, int start, int numOutputs) noexcept
+    {
+        for (int n = start; n < numOutputs; ++n)
+        {
+            float acc = 0.0f;
+            for (int j = 0; j < numTaps; ++j)
+                acc += reversedTaps[j] * history[n + j];
+            out[n] = acc;
+        }
+    }
+
+    void firScalar(float* out, const float* history, const float* reversedTaps,
+                   int numTaps, int numOutputs) noexcept
+    {
+        firScalarTail(out, history, reversedTaps, numTaps, 0, numOutputs);
+    }
+
+#if CONVOLUTION_FIR_X86
+    CONVOLUTION_FIR_TARGET("sse2")
+    void firSse2(float* out, const float* history, const float* reversedTaps,
+                 int numTaps, int numOutputs) noexcept
+    {
+        int n = 0;
+        for (; n + 4 <= numOutputs; n += 4)
+        {
+            __m128 acc = _mm_setzero_ps();
+            for (int j = 0; j < numTaps; ++j)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(reversedTaps[j]), _mm_loadu_ps(history + n + j)));
+            _mm_storeu_ps(out + n, acc);
+        }
+
+        firScalarTail(out, history, reversedTaps, numTaps, n, numOutputs);
+    }
+
+    CONVOLUTION_FIR_TARGET("avx2,fma")
+    void firAvx2(float* out, const float* history, const float* reversedTaps,
+                 int numTaps, int numOutputs) noexcept
+    {
+        int n = 0;
+        for (; n + 8 <= numOutputs; n += 8)
+        {
+            __m256 acc = _mm256_setzero_ps();
+            for (int j = 0; j < numTaps; ++j)
+                acc = _mm256_fmadd_ps(_mm256_set1_ps(reversedTaps[j]), _mm256_loadu_ps(history + n + j), acc);
+            _mm256_storeu_ps(out + n, acc);
+        }
+
+        firScalarTail(out, history, reversedTaps, numTaps, n, numOutputs);
+    }
+
+    CONVOLUTION_FIR_TARGET("avx512f")
+    void firAvx512(float* out, const float* history, const float* reversedTaps,
+                   int numTaps, int numOutputs) noexcept
+    {
+        int n = 0;
+        for (; n + 16 <= numOutputs; n += 16)
+        {
+            __m512 acc = _mm512_setzero_ps();
+            for (int j = 0; j < numTaps; ++j)
+                acc = _mm512_fmadd_ps(_mm512_set1_ps(reversedTaps[j]), _mm512_loadu_ps(history + n + j), acc);
+            _mm512_storeu_ps(out + n, acc);
+        }
+
+        firScalarTail(out, history, reversedTaps, numTaps, n, numOutputs);
+    }
+#endif
+
+#if CONVOLUTION_FIR_NEON
+    void firNeon(float* out, const float* history, const float* reversedTaps,
+                 int numTaps, int numOutputs) noexcept
+    {
+        int n = 0;
+        for (; n + 4 <= numOutputs; n += 4)
+        {
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for (int j = 0; j < numTaps; ++j)
+                acc = vfmaq_n_f32(acc, vld1q_f32(history + n + j), reversedTaps[j]);
+            vst1q_f32(out + n, acc);
+        }
+
+        firScalarTail(out, history, reversedTaps, numTaps, n, numOutputs);
+    }
+#endif
+}
+
+Kernel getKernel()
+{
+    static const Kernel active = DirectFir::getKernel(ComplexMac::getActiveIsa());
+    return active;
+}
+
+Kernel getKernel(ComplexMac::Isa isa)
+{
+    // ComplexMac already knows which variants this CPU can run.
+    if (!ComplexMac::isSupported(isa))
+        return nullptr;
+
+    switch (isa)
+    {
+       #if CONVOLUTION_FIR_X86
+        case ComplexMac::Isa::sse2:   return firSse2;
+        case ComplexMac::Isa::avx2:   return firAvx2;
+        case ComplexMac::Isa::avx512: return firAvx512;
+       #endif
+       #if CONVOLUTION_FIR_NEON
+        case ComplexMac::Isa::neon:   return firNeon;
+       #endif
+        default:                      return firScalar;
+    }
+}
+}
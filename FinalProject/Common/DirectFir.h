@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ComplexMac.h"
+
+// Direct-form FIR used for the zero-latency head of the IR and for short IRs that are cheaper
+// to convolve in the time domain than through FFTs:
+//
+//     out[n] = sum_j reversedTaps[j] * history[n + j]    for n in [0, numOutputs), j in [0, numTaps)
+//
+// `history` holds numTaps - 1 past input samples followed by the numOutputs new ones, and the
+// taps are stored reversed so both streams advance forwards. Kernels vectorise across outputs
+// (one broadcast tap per step), so there are no horizontal sums. Variants follow the same runtime
+// selection as ComplexMac; FMA variants differ from scalar only by rounding.
+namespace DirectFir
+{
+    using Kernel = void (*)(float* out, const float* history, const float* reversedTaps,
+                            int numTaps, int numOutputs) noexcept;
+
+    Kernel getKernel();
+    Kernel getKernel(ComplexMac::Isa isa);
+}
@@ -0,0 +1,150 @@
+#include "FftBackend.h"
+#include "RealFft.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <mutex>
+#include <juce_dsp/juce_dsp.h>
+
+// Build default, set through the CONVOLUTION_FFT_BACKEND CMake option.
+#ifndef CONVOLUTION_FFT_BACKEND
+ #define CONVOLUTION_FFT_BACKEND "juce"
+#endif
+
+namespace
+{
+    class JuceBackend final : public FftBackend
+    {
+    public:
+        explicit JuceBackend(int order) : FftBackend(Kind::juce, order), fft(order) {}
+
+        void forward(const float* input, int numInput, float* real, float* imag, float* work) const noexcept override
+        {
+            // JUCE transforms in place over 2N floats and returns interleaved bins.
+            const int size = getSize();
+            const int count = std::clamp(numInput, 0, size);
+            std::copy(input, input + count, work);
+            std::fill(work + count, work + 2 * size, 0.0f);
+            fft.performRealOnlyForwardTransform(work, true);
+
+            for (int k = 0; k < getNumBins(); ++k)
+            {
+                real[k] = work[k * 2];
+                imag[k] = work[k * 2 + 1];
+            }
+        }
+
+        void inverse(const float* real, const float* imag, float* output, float* work) const noexcept override
+        {
+            // Only the non-negative bins are needed; JUCE mirrors the rest and scales by 1/N.
+            for (int k = 0; k < getNumBins(); ++k)
+            {
+                work[k * 2] = real[k];
+                work[k * 2 + 1] = imag[k];
+            }
+            fft.performRealOnlyInverseTransform(work);
+            std::copy(work, work + getSize(), output);
+        }
+
+    private:
+        juce::dsp::FFT fft;
+    };
+
+    class RealFftBackend final : public FftBackend
+    {
+    public:
+        RealFftBackend(Kind kind, int order)
+            : FftBackend(kind, order),
+              plan(RealFft::getPlan(order, kind == Kind::simd ? RealFft::Variant::simd : RealFft::Variant::scalar)),
+              inverseScale(1.0f / static_cast<float>(plan->getSize()))
+        {
+        }
+
+        void forward(const float* input, int numInput, float* real, float* imag, float*) const noexcept override
+        {
+            plan->forward(input, numInput, real, imag);
+        }
+
+        void inverse(const float* real, const float* imag, float* output, float* work) const noexcept override
+        {
+            plan->inverse(real, imag, output, work, inverseScale);
+        }
+
+    private:
+        std::shared_ptr<const RealFft> plan;
+        float inverseScale = 1.0f;
+    };
+
+    constexpr size_t numKinds = std::size(FftBackend::allKinds);
+
+    FftBackend::Kind parseBuildDefault() noexcept
+    {
+        FftBackend::Kind kind = FftBackend::Kind::juce;
+        FftBackend::parseName(CONVOLUTION_FFT_BACKEND, kind);
+        return kind;
+    }
+
+    std::atomic<FftBackend::Kind> defaultKind{ parseBuildDefault() };
+}
+
+std::shared_ptr<const FftBackend> FftBackend::get(Kind kind, int order)
+{
+    static std::mutex cacheMutex;
+    static std::array<std::array<std::shared_ptr<const FftBackend>, RealFft::maxOrder + 1>, numKinds> cache;
+
+    order = std::clamp(order, RealFft::minOrder, RealFft::maxOrder);
+
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    auto& backend = cache[static_cast<size_t>(kind)][static_cast<size_t>(order)];
+    if (backend == nullptr)
+    {
+        if (kind == Kind::juce)
+            backend = std::make_shared<const JuceBackend>(order);
+        else
+            backend = std::make_shared<const RealFftBackend>(kind, order);
+    }
+    return backend;
+}
+
+FftBackend::Kind FftBackend::getDefaultKind() noexcept
+{
+    return defaultKind.load(std::memory_order_relaxed);
+}
+
+void FftBackend::setDefaultKind(Kind kind) noexcept
+{
+    defaultKind.store(kind, std::memory_order_relaxed);
+}
+
+const char* FftBackend::getName(Kind kind) noexcept
+{
+    switch (kind)
+    {
+        case Kind::juce:    return "juce";
+        case Kind::inHouse: return "inhouse";
+        case Kind::simd:    return "simd";
+    }
+    return "unknown";
+}
+
+bool FftBackend::parseName(const char* name, Kind& kind) noexcept
+{
+    if (name == nullptr)
+        return false;
+
+    for (auto candidate : allKinds)
+    {
+        const char* candidateName = getName(candidate);
+        size_t i = 0;
+        while (name[i] != '\0' && std::tolower(static_cast<unsigned char>(name[i])) == candidateName[i])
+            ++i;
+
+        if (name[i] == '\0' && candidateName[i] == '\0')
+        {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+
+// Real FFT of size N = 2^order behind one interface, so the engine, the IR loader and the
+// benchmark can switch implementations without touching their spectrum layout:
+//
+//     forward:  numInput samples, zero-padded to N -> split half spectrum, N / 2 + 1 bins per plane
+//     inverse:  split half spectrum -> N samples scaled by 1/N (a forward/inverse round trip is unity)
+//
+// Shipped backends:
+//   juce     juce::dsp::FFT (its fastest engine on the platform: vDSP, IPP/MKL when enabled, or the fallback)
+//   inHouse  Common/RealFft, scalar radix-4 passes
+//   simd     Common/RealFft with SSE2/AVX2+FMA/NEON radix-4 passes
+//
+// Backends are immutable and cached per kind and order, so every engine instance and thread
+// shares them; callers pass getWorkSize() floats of their own scratch to every call. The build
+// default comes from the CONVOLUTION_FFT_BACKEND CMake option and can be overridden at runtime.
+class FftBackend
+{
+public:
+    enum class Kind
+    {
+        juce,
+        inHouse,
+        simd
+    };
+
+    static constexpr Kind allKinds[] = { Kind::juce, Kind::inHouse, Kind::simd };
+
+    virtual ~FftBackend() = default;
+
+    // Cached backend for size 2^order. Allocates and locks on first use, so call it from
+    // prepare()/IR loading rather than the audio thread.
+    static std::shared_ptr<const FftBackend> get(Kind kind, int order);
+
+    // Kind used by new engine states and the IR loader when none is given explicitly.
+    static Kind getDefaultKind() noexcept;
+    static void setDefaultKind(Kind kind) noexcept;
+
+    static const char* getName(Kind kind) noexcept;
+    // Accepts the names returned by getName() (case-insensitive); returns false if unknown.
+    static bool parseName(const char* name, Kind& kind) noexcept;
+
+    Kind getKind() const noexcept { return kind; }
+    int getOrder() const noexcept { return order; }
+    int getSize() const noexcept { return 1 << order; }
+    int getNumBins() const noexcept { return getSize() / 2 + 1; }
+    int getWorkSize() const noexcept { return 2 * getSize(); }
+
+    // `real` and `imag` need N / 2 + 1 floats each; nothing past the last bin is written.
+    virtual void forward(const float* input, int numInput, float* real, float* imag, float* work) const noexcept = 0;
+    virtual void inverse(const float* real, const float* imag, float* output, float* work) const noexcept = 0;
+
+protected:
+    FftBackend(Kind backendKind, int fftOrder) : kind(backendKind), order(fftOrder) {}
+
+private:
+    const Kind kind;
+    const int order;
+};
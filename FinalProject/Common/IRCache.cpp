@@ -0,0 +1,273 @@
+#include "IRCache.h"
+#include "ConvolutionEngine.h"
+#include "IRSpectraFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    // One per key. buildMutex serialises loads of the same IR without blocking other keys; data is
+    // written holding both locks, so either one is enough to read it.
+    struct Entry
+    {
+        std::mutex buildMutex;
+        std::weak_ptr<const IRData> data;
+    };
+
+    std::mutex cacheMutex;
+    std::map<IRCache::Key, std::shared_ptr<Entry>> entries;
+    std::optional<juce::File> diskCacheDirectory; // the default is resolved on first use
+    std::atomic<std::int64_t> diskCacheLimit { IRCache::defaultDiskCacheLimit };
+
+    // Needs cacheMutex.
+    const juce::File& getDirectoryLocked()
+    {
+        if (!diskCacheDirectory.has_value())
+            diskCacheDirectory = IRCache::getDefaultDiskCacheDirectory();
+        return *diskCacheDirectory;
+    }
+
+    // Needs cacheMutex. An empty File when the disk cache is off.
+    juce::File getSpectraFileLocked(const IRCache::Key& key)
+    {
+        const auto& directory = getDirectoryLocked();
+        return directory == juce::File() ? juce::File() : directory.getChildFile(IRSpectraFile::getFileName(key));
+    }
+
+    // Deletes the least recently used spectra files in directory until the rest fit the limit.
+    // Reads bump a file's modification time (access times are often not kept), so that is the
+    // order of last use. Files another process is writing are the newest, so they go last.
+    void trimDiskCache(const juce::File& directory)
+    {
+        const auto limit = diskCacheLimit.load();
+        std::vector<std::pair<juce::Time, juce::File>> files;
+        std::int64_t totalSize = 0;
+        for (const auto& file : directory.findChildFiles(juce::File::findFiles, false, "*.irspectra"))
+        {
+            files.emplace_back(file.getLastModificationTime(), file);
+            totalSize += file.getSize();
+        }
+
+        if (totalSize <= limit)
+            return;
+
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& [modified, file] : files)
+        {
+            if (totalSize <= limit)
+                break;
+
+            const auto size = file.getSize();
+            if (file.deleteFile())
+                totalSize -= size;
+        }
+    }
+
+    void writeToDisk(const juce::File& spectraFile, const IRCache::Key& key, const IRData& data)
+    {
+        if (IRSpectraFile::write(spectraFile, key, data))
+            trimDiskCache(spectraFile.getParentDirectory());
+    }
+
+    // Drops entries whose IR has been released and that no loader is working on. Needs cacheMutex.
+    void pruneExpired()
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.use_count() == 1 && it->second->data.expired())
+                it = entries.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+bool IRCache::Key::operator<(const Key& other) const
+{
+    const auto tie = [](const Key& key) {
+        return std::tie(key.contentHash, key.contentSize, key.sampleRate, key.partitionSize, key.fftOrder,
+                        key.directLength, key.offlinePlanning, key.spectrumFormat, key.fullPrecisionSamples,
+                        key.fftBackend);
+    };
+    return tie(*this) < tie(other);
+}
+
+void IRCache::Hasher::add(const void* data, size_t numBytes) noexcept
+{
+    constexpr std::uint64_t prime = 0x100000001b3ull;
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    while (numBytes > 0)
+    {
+        const size_t take = std::min(numBytes, sizeof(pending) - numPending);
+        std::memcpy(pending + numPending, bytes, take);
+        numPending += take;
+        bytes += take;
+        numBytes -= take;
+
+        if (numPending == sizeof(pending))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, pending, sizeof(word));
+            hash = (hash ^ word) * prime;
+            numPending = 0;
+        }
+    }
+}
+
+std::uint64_t IRCache::Hasher::get() const noexcept
+{
+    if (numPending == 0)
+        return hash;
+
+    std::uint64_t word = 0;
+    std::memcpy(&word, pending, numPending);
+    return (hash ^ word) * 0x100000001b3ull;
+}
+
+bool IRCache::hashFile(const juce::File& file, std::uint64_t& hash, std::int64_t& size)
+{
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+        return false;
+
+    Hasher hasher;
+    size = 0;
+
+    std::vector<char> chunk(1 << 16);
+    for (;;)
+    {
+        const int bytesRead = stream.read(chunk.data(), static_cast<int>(chunk.size()));
+        if (bytesRead <= 0)
+            break;
+
+        hasher.add(chunk.data(), static_cast<size_t>(bytesRead));
+        size += bytesRead;
+    }
+
+    hash = hasher.get();
+    return true;
+}
+
+std::shared_ptr<const IRData> IRCache::findOrBuild(const Key& key,
+                                                   const std::function<std::shared_ptr<const IRData>()>& build)
+{
+    std::shared_ptr<Entry> entry;
+    juce::File spectraFile;
+    {
+        const std::lock_guard<std::mutex> lock(cacheMutex);
+        pruneExpired();
+        auto& slot = entries[key];
+        if (slot == nullptr)
+            slot = std::make_shared<Entry>();
+        entry = slot;
+        spectraFile = getSpectraFileLocked(key);
+    }
+
+    const std::lock_guard<std::mutex> buildLock(entry->buildMutex);
+    if (auto data = entry->data.lock())
+        return data;
+
+    // A spectra file that is missing, stale or damaged is simply rebuilt and written again. A
+    // progressive build is written by its loader once it is complete (storeOnDisk).
+    std::shared_ptr<const IRData> data;
+    if (spectraFile != juce::File())
+        data = IRSpectraFile::read(spectraFile, key);
+
+    if (data != nullptr)
+    {
+        spectraFile.setLastModificationTime(juce::Time::getCurrentTime());
+    }
+    else
+    {
+        data = build();
+        if (data != nullptr && data->isComplete() && spectraFile != juce::File())
+            writeToDisk(spectraFile, key, *data);
+    }
+
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    entry->data = data;
+    return data;
+}
+
+void IRCache::storeOnDisk(const Key& key, const IRData& data)
+{
+    juce::File spectraFile;
+    {
+        const std::lock_guard<std::mutex> lock(cacheMutex);
+        spectraFile = getSpectraFileLocked(key);
+    }
+
+    if (spectraFile != juce::File())
+        writeToDisk(spectraFile, key, data);
+}
+
+void IRCache::forget(const Key& key, const IRData* data)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        const std::lock_guard<std::mutex> lock(cacheMutex);
+        const auto it = entries.find(key);
+        if (it == entries.end())
+            return;
+        entry = it->second;
+    }
+
+    const std::lock_guard<std::mutex> buildLock(entry->buildMutex);
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    if (entry->data.lock().get() == data)
+        entry->data.reset();
+}
+
+int IRCache::getNumLiveEntries()
+{
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    int live = 0;
+    for (const auto& [key, entry] : entries)
+        live += entry->data.expired() ? 0 : 1;
+    return live;
+}
+
+void IRCache::setDiskCacheDirectory(const juce::File& directory)
+{
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    diskCacheDirectory = directory;
+}
+
+juce::File IRCache::getDiskCacheDirectory()
+{
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    return getDirectoryLocked();
+}
+
+juce::File IRCache::getDefaultDiskCacheDirectory()
+{
+    // Spectra are large and rebuilt on demand, so they stay out of roaming profiles and config
+    // folders that get synced or backed up.
+#if JUCE_MAC
+    return juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile("Library/Caches/Convolution_Reverb/IRSpectra");
+#elif JUCE_WINDOWS
+    return juce::File::getSpecialLocation(juce::File::windowsLocalAppData).getChildFile("Convolution_Reverb/IRSpectra");
+#else
+    const auto xdgCache = juce::SystemStats::getEnvironmentVariable("XDG_CACHE_HOME", {});
+    const auto cacheRoot = juce::File::isAbsolutePath(xdgCache) ? juce::File(xdgCache)
+                                                                : juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile(".cache");
+    return cacheRoot.getChildFile("Convolution_Reverb/IRSpectra");
+#endif
+}
+
+void IRCache::setDiskCacheLimit(std::int64_t numBytes)
+{
+    diskCacheLimit.store(std::max<std::int64_t>(numBytes, 0));
+}
+
+std::int64_t IRCache::getDiskCacheLimit()
+{
+    return diskCacheLimit.load();
+}
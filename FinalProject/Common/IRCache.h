@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <juce_core/juce_core.h>
+#include "ComplexMac.h"
+#include "FftBackend.h"
+
+struct IRData;
+
+// Process-wide cache of loaded IRs, so every plugin instance that loads the same file with the
+// same plan shares one IRData instead of decoding and transforming it again. Entries hold weak
+// references only: an IR lives as long as some engine or loader still uses it, and the cache
+// forgets it once the last one lets go. Concurrent loads of the same key wait for the first one
+// rather than building their own copy.
+//
+// Behind it sits a persistent cache of spectra files (IRSpectraFile), one per key, so the next
+// session maps an IR's spectra from disk instead of rebuilding them. The folder is kept under a
+// size limit by deleting the least recently used files whenever one is written.
+class IRCache
+{
+public:
+    // Everything the loader's output depends on: the file's bytes and the partition plan.
+    struct Key
+    {
+        std::uint64_t contentHash = 0;
+        std::int64_t contentSize = 0;
+        double sampleRate = 0.0;
+        int partitionSize = 0; // head tier
+        int fftOrder = 0;      // head tier
+        int directLength = 0;  // FIR head, 0 without one
+        bool offlinePlanning = false;
+        ComplexMac::SpectrumFormat spectrumFormat = ComplexMac::SpectrumFormat::fp32;
+        int fullPrecisionSamples = 0;
+        FftBackend::Kind fftBackend = FftBackend::Kind::juce;
+
+        bool operator<(const Key& other) const;
+    };
+
+    // FNV-1a over 64-bit words, fed in pieces of any size (the final partial word is zero-padded).
+    // Not cryptographic; it tells IR files apart and catches damaged cache files.
+    class Hasher
+    {
+    public:
+        void add(const void* data, size_t numBytes) noexcept;
+        std::uint64_t get() const noexcept;
+
+    private:
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        unsigned char pending[8] = {};
+        size_t numPending = 0;
+    };
+
+    // Hash of a file's contents. Returns false if the file cannot be read.
+    static bool hashFile(const juce::File& file, std::uint64_t& hash, std::int64_t& size);
+
+    // Returns the live IR for key. Otherwise it maps the key's spectra file from the disk cache,
+    // or calls build (without holding the cache lock) and writes the result there. A null result
+    // is not cached. Locks, allocates and does file I/O; never call from the audio thread.
+    static std::shared_ptr<const IRData> findOrBuild(const Key& key,
+                                                     const std::function<std::shared_ptr<const IRData>()>& build);
+
+    // Writes a progressively loaded IR to the disk cache once its loader has filled it in.
+    static void storeOnDisk(const Key& key, const IRData& data);
+
+    // Drops data from the cache if it is still the entry for key, so later loads build the IR
+    // again. For loads abandoned before they were complete.
+    static void forget(const Key& key, const IRData* data);
+
+    // IRs currently shared through the cache.
+    static int getNumLiveEntries();
+
+    // Where spectra files are kept: by default a folder in the user's local (never roaming) cache
+    // location. An empty File turns the disk cache off; IRs already loaded are not affected.
+    static void setDiskCacheDirectory(const juce::File& directory);
+    static juce::File getDiskCacheDirectory();
+    static juce::File getDefaultDiskCacheDirectory();
+
+    // Total size the spectra files may take up. Past it, the files used longest ago are deleted
+    // after each write; a file in use stays valid, since it is mapped (and on Windows cannot be
+    // deleted at all).
+    static constexpr std::int64_t defaultDiskCacheLimit = std::int64_t(1) << 30;
+    static void setDiskCacheLimit(std::int64_t numBytes);
+    static std::int64_t getDiskCacheLimit();
+};
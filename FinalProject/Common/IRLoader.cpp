@@ -0,0 +1,619 @@
+#include "IRLoader.h"
+#include "IRCache.h"
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+
+namespace
+{
+    // Encodes one fp32 spectrum as fp16/bf16 and returns the scale to multiply it by. fp16
+    // spectra are scaled so their largest component sits at 2^15: well clear of the 65504 limit,
+    // with about 29 octaves of normal range below it. bf16 shares float's exponent range and
+    // needs no scale.
+    float encodeCompactSpectrum(ComplexMac::SpectrumFormat format, const float* real, const float* imag, int bins,
+                                uint16_t* compactReal, uint16_t* compactImag)
+    {
+        float peak = 0.0f;
+        for (int k = 0; k < bins; ++k)
+            peak = std::max({ peak, std::abs(real[k]), std::abs(imag[k]) });
+
+        float scale = 1.0f;
+        if (format == ComplexMac::SpectrumFormat::fp16 && peak > 0.0f)
+            scale = peak / 32768.0f;
+
+        const float inverseScale = 1.0f / scale;
+        for (int k = 0; k < bins; ++k)
+        {
+            compactReal[k] = ComplexMac::encode(format, real[k] * inverseScale);
+            compactImag[k] = ComplexMac::encode(format, imag[k] * inverseScale);
+        }
+        return scale;
+    }
+
+    // Mono and stereo IRs are kept per channel and 4-channel IRs as a true-stereo matrix; anything
+    // else is folded to mono.
+    int getNumPaths(int fileChannels)
+    {
+        return fileChannels == 1 || fileChannels == 2 || fileChannels == 4 ? fileChannels : 1;
+    }
+
+    // Length at sampleRate of an IR of sourceLength samples at sourceRate, and the resampler that
+    // converts it (null when the rates match or either is unknown). False if it would be longer
+    // than IRLoader::maxIRLength.
+    bool planResampling(double sourceRate, double sampleRate, juce::int64 sourceLength,
+                        std::shared_ptr<const Resampler>& resampler, juce::int64& irLength)
+    {
+        irLength = sourceLength;
+        if (sourceRate > 0.0 && sampleRate > 0.0 && std::llround(sourceRate) != std::llround(sampleRate))
+        {
+            // Checked in floating point first, so a damaged header cannot overflow the exact count.
+            if (static_cast<double>(sourceLength) * (sampleRate / sourceRate) > static_cast<double>(IRLoader::maxIRLength))
+                return false;
+
+            resampler = std::make_shared<const Resampler>(sourceRate, sampleRate);
+            irLength = resampler->getOutputLength(sourceLength);
+        }
+
+        return irLength <= IRLoader::maxIRLength;
+    }
+
+    // Transforms IR partitions into their (preallocated) spectra, one partition of one path at a time.
+    class PartitionTransformer
+    {
+    public:
+        explicit PartitionTransformer(FftBackend::Kind kind) : fftKind(kind) {}
+
+        // count samples of a path starting at the partition's first IR sample; the rest of the
+        // partition is zero.
+        void transform(IRPartitionTier& tier, int partition, size_t path, const float* samples, int count)
+        {
+            if (fft == nullptr || fft->getSize() != tier.fftSize)
+            {
+                fft = FftBackend::get(fftKind, tier.fftOrder);
+                work.assign(static_cast<size_t>(fft->getWorkSize()), 0.0f);
+            }
+
+            // Each partition is padded to fftSize and transformed once up front; only the
+            // non-negative half of the spectrum is kept.
+            if (tier.format == ComplexMac::SpectrumFormat::fp32)
+            {
+                auto& spectra = tier.spectra[path];
+                fft->forward(samples, count, spectra.real(partition), spectra.imag(partition), work.data());
+                return;
+            }
+
+            const int bins = tier.fftSize / 2 + 1;
+            if (full.getNumBins() != bins)
+                full.allocate(1, bins);
+
+            fft->forward(samples, count, full.real(0), full.imag(0), work.data());
+            auto& compact = tier.compactSpectra[path];
+            tier.compactScales[path][static_cast<size_t>(partition)]
+                = encodeCompactSpectrum(tier.format, full.real(0), full.imag(0), bins,
+                                        compact.real(partition), compact.imag(partition));
+        }
+
+    private:
+        const FftBackend::Kind fftKind;
+        std::shared_ptr<const FftBackend> fft;
+        std::vector<float> work;
+        SpectrumBuffer full; // fp32 spectrum before it is compacted
+    };
+
+    // Allocates a tier's spectra (zeroed) in its format. Done per tier as it is filled in, so a
+    // progressive load does not pay for the whole IR's memory before its head is audible; the
+    // audio thread only looks at a tier's spectra once one of its partitions is ready.
+    void allocateTierSpectra(IRPartitionTier& tier, int numPaths)
+    {
+        const int bins = tier.fftSize / 2 + 1;
+        if (tier.format == ComplexMac::SpectrumFormat::fp32)
+        {
+            tier.spectra.resize(static_cast<size_t>(numPaths));
+            for (auto& spectra : tier.spectra)
+                spectra.allocate(tier.numPartitions, bins);
+            return;
+        }
+
+        tier.compactSpectra.resize(static_cast<size_t>(numPaths));
+        tier.compactScales.assign(static_cast<size_t>(numPaths), std::vector<float>(static_cast<size_t>(tier.numPartitions), 1.0f));
+        for (auto& spectra : tier.compactSpectra)
+            spectra.allocate(tier.numPartitions, bins);
+    }
+
+    // One thread's share of a load: its own transformer and scratch, sized up front for the
+    // largest partition, and its own reader when the samples come from a file (a reader cannot be
+    // shared between threads). IRs at another sample rate are resampled here, a partition at a
+    // time, from just the source samples that partition needs.
+    class PartitionWorker
+    {
+    public:
+        PartitionWorker(FftBackend::Kind kind, int numFileChannels, int maxSamples,
+                        std::unique_ptr<juce::AudioFormatReader> fileReader,
+                        std::shared_ptr<const Resampler> fileResampler)
+            : reader(std::move(fileReader)), resampler(std::move(fileResampler)), fileChannels(numFileChannels),
+              transformer(kind),
+              input(resampler != nullptr ? numFileChannels : 0,
+                    resampler != nullptr ? resampler->getSourceRange(0, maxSamples).length + 1 : 0),
+              block(reader != nullptr || resampler != nullptr ? numFileChannels : 0,
+                    reader != nullptr || resampler != nullptr ? maxSamples : 0),
+              mono(static_cast<size_t>(getNumPaths(numFileChannels) == numFileChannels ? 0 : maxSamples)),
+              channels(static_cast<size_t>(numFileChannels))
+        {
+        }
+
+        // count samples of every path from IR sample offset, decoded from this worker's reader
+        // or taken from source without one. Valid until the next call.
+        const std::vector<const float*>& readPaths(int offset, int count, const juce::AudioBuffer<float>* source)
+        {
+            if (resampler != nullptr)
+            {
+                // Only the part of the source range inside the IR is read; the rest is zero.
+                const auto range = resampler->getSourceRange(offset, count);
+                const auto sourceLength = reader != nullptr ? reader->lengthInSamples : static_cast<juce::int64>(source->getNumSamples());
+                const auto first = std::max<juce::int64>(range.first, 0);
+                const auto end = std::min<juce::int64>(range.first + range.length, sourceLength);
+                input.clear(0, range.length);
+                if (end > first && reader != nullptr)
+                    reader->read(&input, static_cast<int>(first - range.first), static_cast<int>(end - first), first, true, true);
+                else if (end > first)
+                    for (int ch = 0; ch < fileChannels; ++ch)
+                        input.copyFrom(ch, static_cast<int>(first - range.first), *source, ch, static_cast<int>(first), static_cast<int>(end - first));
+
+                for (int ch = 0; ch < fileChannels; ++ch)
+                {
+                    resampler->process(input.getReadPointer(ch), block.getWritePointer(ch), offset, count);
+                    channels[static_cast<size_t>(ch)] = block.getReadPointer(ch);
+                }
+            }
+            else if (reader != nullptr)
+            {
+                reader->read(&block, 0, count, offset, true, true);
+                for (int ch = 0; ch < fileChannels; ++ch)
+                    channels[static_cast<size_t>(ch)] = block.getReadPointer(ch);
+            }
+            else
+            {
+                for (int ch = 0; ch < fileChannels; ++ch)
+                    channels[static_cast<size_t>(ch)] = source->getReadPointer(ch) + offset;
+            }
+
+            if (mono.empty())
+                return channels;
+
+            const float scale = 1.0f / static_cast<float>(fileChannels);
+            std::fill(mono.begin(), mono.begin() + count, 0.0f);
+            for (const float* src : channels)
+                for (int n = 0; n < count; ++n)
+                    mono[static_cast<size_t>(n)] += src[n];
+            for (int n = 0; n < count; ++n)
+                mono[static_cast<size_t>(n)] *= scale;
+
+            monoPath.assign(1, mono.data());
+            return monoPath;
+        }
+
+        // Decodes partition p of tier and transforms each of its paths.
+        void run(IRData& data, IRPartitionTier& tier, int p, const juce::AudioBuffer<float>* source)
+        {
+            const int offset = std::min(tier.irOffset + p * tier.partitionSize, data.irLength);
+            const int count = std::min(tier.partitionSize, data.irLength - offset);
+            const auto& paths = readPaths(offset, count, source);
+            for (size_t path = 0; path < paths.size(); ++path)
+                transformer.transform(tier, p, path, paths[path], count);
+        }
+
+    private:
+        const std::unique_ptr<juce::AudioFormatReader> reader;
+        const std::shared_ptr<const Resampler> resampler;
+        const int fileChannels;
+        PartitionTransformer transformer;
+        juce::AudioBuffer<float> input;       // the file's channels at its own rate, when resampling
+        juce::AudioBuffer<float> block;       // the file's channels, decoded
+        std::vector<float> mono;              // folded path, when the file's channels are not kept
+        std::vector<const float*> channels;   // this partition's samples of each file channel
+        std::vector<const float*> monoPath;
+    };
+
+    // Workers for a load, as many as threads allows. File loads get a reader each, and fewer
+    // workers if the file cannot be opened that many times.
+    std::vector<std::unique_ptr<PartitionWorker>> createWorkers(const IRData& data, int fileChannels, int threads,
+                                                                FftBackend::Kind kind,
+                                                                const std::function<std::unique_ptr<juce::AudioFormatReader>()>& openReader,
+                                                                const std::shared_ptr<const Resampler>& resampler)
+    {
+        const int maxSamples = std::max(data.directLength, data.tiers.empty() ? 0 : data.tiers.back().partitionSize);
+        std::vector<std::unique_ptr<PartitionWorker>> workers;
+        for (int w = 0; w < std::max(1, std::min(threads, data.totalPartitions)); ++w)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader;
+            if (openReader != nullptr && (reader = openReader()) == nullptr)
+                break;
+            workers.push_back(std::make_unique<PartitionWorker>(kind, fileChannels, maxSamples, std::move(reader), resampler));
+        }
+        return workers;
+    }
+
+    // Transforms partitions [first, end) (counted across tiers, in IR order) and then marks them
+    // ready. The calling thread runs the first worker and the pool runs the others; each takes the
+    // next untransformed partition until none are left, so the long tail partitions balance
+    // themselves across threads. Every job is waited for: they use this frame's state.
+    void transformPartitions(IRData& data, int first, int end, std::vector<std::unique_ptr<PartitionWorker>>& workers,
+                             const juce::AudioBuffer<float>* source, juce::ThreadPool& pool)
+    {
+        if (first >= end || workers.empty())
+            return;
+
+        for (auto& tier : data.tiers)
+            if (tier.firstPartition < end && tier.firstPartition + tier.numPartitions > first
+                && tier.spectra.empty() && tier.compactSpectra.empty())
+                allocateTierSpectra(tier, data.numChannels);
+
+        std::atomic<int> next{ first };
+        auto runWorker = [&](PartitionWorker& worker) {
+            size_t t = 0;
+            for (int partition = next++; partition < end; partition = next++)
+            {
+                while (partition >= data.tiers[t].firstPartition + data.tiers[t].numPartitions)
+                    ++t;
+                auto& tier = data.tiers[t];
+                worker.run(data, tier, partition - tier.firstPartition, source);
+            }
+        };
+
+        const int numJobs = std::min(static_cast<int>(workers.size()), end - first) - 1;
+        std::atomic<int> jobsRunning{ numJobs };
+        juce::WaitableEvent jobsFinished;
+        for (int j = 1; j <= numJobs; ++j)
+        {
+            pool.addJob([&, j] {
+                runWorker(*workers[static_cast<size_t>(j)]);
+                if (--jobsRunning == 0)
+                    jobsFinished.signal();
+            });
+        }
+
+        runWorker(*workers.front());
+        if (numJobs > 0)
+            jobsFinished.wait();
+
+        data.readyPartitions.store(end, std::memory_order_release);
+    }
+
+    // Decodes and transforms the tail of a progressively loaded IR in IR order, a batch of
+    // partitions at a time spread over the transform threads, publishing each batch as it
+    // completes. Runs on the process-wide fill pool, so it carries on for as long as any engine or
+    // loader holds the IR, whichever loader started it; it only keeps a weak reference, and stops
+    // once the last holder lets go. Writes the finished IR to the disk cache.
+    class PartitionFillJob : public juce::ThreadPoolJob
+    {
+    public:
+        PartitionFillJob(const std::shared_ptr<IRData>& irToFill, std::vector<std::unique_ptr<PartitionWorker>> fillWorkers,
+                         juce::ThreadPool& threads, const IRCache::Key& cacheKey)
+            : juce::ThreadPoolJob("IR partition fill"), data(irToFill), workers(std::move(fillWorkers)),
+              pool(threads), key(cacheKey)
+        {
+        }
+
+        // Jobs removed before they finish end up here. That only happens when the fill pool itself
+        // shuts down with the last loader in the process, so drop the IR from the memory cache
+        // then: nobody else should get an IR that will never be completed.
+        ~PartitionFillJob() override
+        {
+            if (const auto ir = data.lock(); ir != nullptr && !ir->isComplete())
+                IRCache::forget(key, ir.get());
+        }
+
+        JobStatus runJob() override
+        {
+            // A couple of partitions per worker keeps the threads busy while still making the
+            // tail audible in small steps.
+            const int batchSize = 2 * static_cast<int>(workers.size());
+            for (;;)
+            {
+                const auto ir = data.lock();
+                if (ir == nullptr || shouldExit())
+                    return jobHasFinished;
+
+                const int first = ir->readyPartitions.load();
+                if (first >= ir->totalPartitions)
+                {
+                    IRCache::storeOnDisk(key, *ir);
+                    return jobHasFinished;
+                }
+
+                transformPartitions(*ir, first, std::min(first + batchSize, ir->totalPartitions), workers, nullptr, pool);
+            }
+        }
+
+    private:
+        const std::weak_ptr<IRData> data;
+        std::vector<std::unique_ptr<PartitionWorker>> workers;
+        juce::ThreadPool& pool;
+        const IRCache::Key key;
+    };
+}
+
+IRLoader::IRLoader()
+{
+    formatManager.registerBasicFormats();
+}
+
+std::shared_ptr<const IRData> IRLoader::loadIR(const juce::File& file,
+                                               double sampleRate,
+                                               int blockSize)
+{
+    auto reader = createReader(file);
+    if (!reader)
+        return nullptr;
+
+    const juce::int64 fileLength = reader->lengthInSamples;
+    if (fileLength <= 0 || reader->numChannels <= 0)
+        return nullptr;
+
+    // IRs recorded at another rate are resampled to the session rate as they are decoded; the
+    // plan, and the cache key, are for the IR at the session rate.
+    std::shared_ptr<const Resampler> resampler;
+    juce::int64 irLength = 0;
+    if (!planResampling(reader->sampleRate, sampleRate, fileLength, resampler, irLength))
+        return nullptr;
+
+    const auto totalSamples = static_cast<int>(irLength);
+
+    // The header gives the length, which is all the partition plan needs, so instances that load
+    // the same file with the same plan share one IRData and only the first one decodes it.
+    IRCache::Key key;
+    if (!IRCache::hashFile(file, key.contentHash, key.contentSize))
+        return nullptr;
+
+    const auto plan = planHead(totalSamples, blockSize);
+    key.sampleRate = sampleRate;
+    key.partitionSize = plan.partitionSize;
+    key.fftOrder = computeFFTOrder(plan.partitionSize * 2);
+    key.directLength = plan.directLength;
+    key.offlinePlanning = offlinePlanning.load();
+    key.spectrumFormat = spectrumFormat.load();
+    key.fullPrecisionSamples = key.spectrumFormat == ComplexMac::SpectrumFormat::fp32 ? 0 : fullPrecisionSamples.load();
+    key.fftBackend = FftBackend::getDefaultKind();
+
+    return IRCache::findOrBuild(key, [&]() -> std::shared_ptr<const IRData> {
+        const int fileChannels = static_cast<int>(reader->numChannels);
+        auto data = createIRData(getNumPaths(fileChannels), totalSamples, blockSize);
+
+        // Each worker decodes its own partitions; the first one takes over this reader.
+        auto workers = createWorkers(*data, fileChannels, getNumLoadThreads(), key.fftBackend, [&] {
+            return reader != nullptr ? std::move(reader) : createReader(file);
+        }, resampler);
+        if (workers.empty())
+            return nullptr;
+
+        if (data->directLength > 0)
+            fillDirectTaps(*data, workers.front()->readPaths(0, data->directLength, nullptr));
+
+        // Progressive loads transform only the head tier here, which is enough to start
+        // convolving; the rest is filled in on the process-wide fill thread.
+        const bool progressive = progressiveLoading.load() && data->tiers.size() > 1;
+        const int headPartitions = progressive ? data->tiers.front().numPartitions : data->totalPartitions;
+        transformPartitions(*data, 0, headPartitions, workers, nullptr, transformThreads->pool);
+
+        if (progressive)
+            transformThreads->fillPool.addJob(new PartitionFillJob(data, std::move(workers), transformThreads->pool, key), true);
+
+        return data;
+    });
+}
+
+std::shared_ptr<const IRData> IRLoader::loadIR(const juce::AudioBuffer<float>& irBuffer,
+                                               double sampleRate,
+                                               int blockSize,
+                                               double bufferSampleRate)
+{
+    const int bufferSamples = irBuffer.getNumSamples();
+    const int fileChannels = irBuffer.getNumChannels();
+    if (bufferSamples <= 0 || fileChannels <= 0)
+        return nullptr;
+
+    std::shared_ptr<const Resampler> resampler;
+    juce::int64 irLength = 0;
+    if (!planResampling(bufferSampleRate, sampleRate, bufferSamples, resampler, irLength))
+        return nullptr;
+
+    // Each path is partitioned in the time domain before transforming each partition to the
+    // frequency domain, straight from the caller's buffer (or through the resampler).
+    auto data = createIRData(getNumPaths(fileChannels), static_cast<int>(irLength), blockSize);
+    auto workers = createWorkers(*data, fileChannels, getNumLoadThreads(), FftBackend::getDefaultKind(), nullptr, resampler);
+    if (data->directLength > 0)
+        fillDirectTaps(*data, workers.front()->readPaths(0, data->directLength, &irBuffer));
+
+    transformPartitions(*data, 0, data->totalPartitions, workers, &irBuffer, transformThreads->pool);
+
+    return data;
+}
+
+std::unique_ptr<juce::AudioFormatReader> IRLoader::createReader(const juce::File& file)
+{
+    // WAV and AIFF are decoded straight from a mapping of the file: no read calls and no copy
+    // through the reader's own buffer, and the pages stay the OS's file cache rather than becoming
+    // part of the process's heap. Other formats are streamed.
+    if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+}
+
+int IRLoader::getNumLoadThreads() const
+{
+    const int available = transformThreads->pool.getNumThreads() + 1;
+    const int requested = numLoadThreads.load();
+    return requested > 0 ? std::min(requested, available) : available;
+}
+
+std::shared_ptr<IRData> IRLoader::createIRData(int numPaths, int irLength, int blockSize) const
+{
+    const auto plan = planHead(irLength, blockSize);
+
+    auto data = std::make_shared<IRData>();
+    data->numChannels = numPaths;
+    data->layout = numPaths == 4 ? IRData::Layout::trueStereo : IRData::Layout::perChannel;
+    data->irLength = irLength;
+    data->directLength = plan.directLength;
+    data->partitionSize = plan.partitionSize;
+    data->tiers = planTiers(plan.partitionSize, data->directLength, irLength);
+
+    // Tail tiers past the full-precision length are transformed straight into fp16/bf16 storage.
+    const auto format = spectrumFormat.load();
+    for (size_t t = 0; t < data->tiers.size(); ++t)
+    {
+        auto& tier = data->tiers[t];
+        data->totalPartitions = tier.firstPartition + tier.numPartitions;
+        if (format != ComplexMac::SpectrumFormat::fp32 && t > 0 && tier.irOffset >= fullPrecisionSamples.load())
+            tier.format = format;
+    }
+
+    return data;
+}
+
+void IRLoader::fillDirectTaps(IRData& data, const std::vector<const float*>& paths)
+{
+    for (const float* path : paths)
+        data.directTaps.emplace_back(std::make_reverse_iterator(path + data.directLength), std::make_reverse_iterator(path));
+}
+
+IRLoader::HeadPlan IRLoader::planHead(int irLength, int blockSize) const
+{
+    // The direct FIR head costs one tap per sample for every head sample, so a zero-latency head
+    // uses a smaller first partition than the host block would otherwise suggest.
+    constexpr int maxDirectHeadLength = 256;
+    const bool offline = offlinePlanning.load();
+
+    HeadPlan plan;
+    plan.partitionSize = offline ? computeOfflinePartitionSize(irLength) : computePartitionSize(blockSize);
+
+    if (prefersDirectConvolution(irLength, plan.partitionSize))
+    {
+        plan.directLength = irLength;
+    }
+    else if (zeroLatency.load() && !offline)
+    {
+        plan.partitionSize = std::min(plan.partitionSize, maxDirectHeadLength);
+        plan.directLength = std::min(plan.partitionSize, irLength);
+    }
+
+    return plan;
+}
+
+int IRLoader::computePartitionSize(int hostBlockSize) const
+{
+    // Use the next power of two for efficient FFT. The non-uniform tiers keep small heads cheap,
+    // so the floor only stops tiny host blocks from producing FFTs that are mostly overhead.
+    int size = juce::nextPowerOfTwo(hostBlockSize);
+    return std::max(size, 64);
+}
+
+int IRLoader::computeOfflinePartitionSize(int irLength) const
+{
+    // Without a latency budget every tier can be uniform, so only the cost per sample matters:
+    // (2·fftCost + numPartitions)·(P+1)/P in partition-MAC units. Larger partitions trade fewer
+    // MAC passes for longer FFTs, down to a single partition covering the whole IR. The realtime
+    // model's (5/16)·log2 N per FFT assumes cache-resident transforms; at these sizes an FFT costs
+    // about log2 N units (measured best sizes: 16384 for a 1 s IR, 65536 for 6 s, 131072 for
+    // 20 s at 48 kHz). Sizes below the largest tier size would be split into growing tiers, so the
+    // search starts there unless one smaller partition covers the IR.
+    constexpr int maxTierPartitionSize = 8192;
+    constexpr int maxOfflinePartitionSize = 1 << 17;
+
+    const int wholeIR = juce::nextPowerOfTwo(std::max(irLength, 1));
+    int size = std::max(64, std::min(wholeIR, maxTierPartitionSize));
+    int bestSize = size;
+    double bestCost = 0.0;
+
+    for (; size <= maxOfflinePartitionSize; size *= 2)
+    {
+        const int numPartitions = (irLength + size - 1) / size;
+        const double binsPerSample = static_cast<double>(size + 1) / size;
+        const double cost = binsPerSample * (2.0 * computeFFTOrder(size * 2) + numPartitions);
+        if (size == bestSize || cost < bestCost)
+        {
+            bestSize = size;
+            bestCost = cost;
+        }
+
+        if (numPartitions == 1)
+            break;
+    }
+
+    return bestSize;
+}
+
+bool IRLoader::prefersDirectConvolution(int irLength, int partitionSize) const
+{
+    // Compare per-sample cost in partition-MAC units (one complex multiply-add per bin), the same
+    // measure the engine schedules tail work in. A uniform FFT path pays a forward and inverse FFT
+    // of 2P points ((5/16)·log2 N units each) plus one MAC pass per partition, all spread over P
+    // samples. A direct tap is a single real FMA on contiguous data, roughly an eighth of a bin's
+    // complex MAC once vectorised. In practice this keeps IRs up to roughly 50-80 taps direct.
+    constexpr double directTapCost = 0.125;
+
+    const int fftOrder = computeFFTOrder(partitionSize * 2);
+    const int numPartitions = (irLength + partitionSize - 1) / partitionSize;
+    const double binsPerSample = static_cast<double>(partitionSize + 1) / partitionSize;
+    const double fftCost = binsPerSample * (2.0 * (5.0 / 16.0) * fftOrder + numPartitions);
+    const double directCost = directTapCost * irLength;
+
+    return directCost <= fftCost;
+}
+
+int IRLoader::computeFFTOrder(int fftSize) const
+{
+    int order = 0;
+    int size = 1;
+    while (size < fftSize)
+    {
+        size <<= 1;
+        ++order;
+    }
+    return order;
+}
+
+std::vector<IRPartitionTier> IRLoader::planTiers(int headPartitionSize, int firstOffset, int irLength) const
+{
+    // Each tier is tierGrowth times larger than the previous one. A tier of size P starts at
+    // least 2P samples into the IR: its block is only complete P samples after it began, and the
+    // second period is slack in which the tier's work can run on a background worker (or be spread
+    // over several callbacks). The previous tier covers everything up to there. With a direct FIR
+    // head the first tier starts at firstOffset and gathers its blocks like the others.
+    constexpr int tierGrowth = 4;
+    constexpr int maxTierPartitionSize = 8192;
+
+    std::vector<IRPartitionTier> tiers;
+    int offset = firstOffset;
+    int size = headPartitionSize;
+
+    while (offset < irLength)
+    {
+        const int nextSize = std::max(size, std::min(size * tierGrowth, maxTierPartitionSize));
+        const int remainingPartitions = (irLength - offset + size - 1) / size;
+        const int partitionsToNextTier = (2 * nextSize - offset + size - 1) / size;
+        const int count = nextSize == size ? remainingPartitions
+                                           : std::min(remainingPartitions, std::max(1, partitionsToNextTier));
+
+        IRPartitionTier tier;
+        tier.partitionSize = size;
+        tier.fftSize = size * 2;
+        tier.fftOrder = computeFFTOrder(tier.fftSize);
+        tier.numPartitions = count;
+        tier.irOffset = offset;
+        tier.firstPartition = tiers.empty() ? 0 : tiers.back().firstPartition + tiers.back().numPartitions;
+        tiers.push_back(std::move(tier));
+
+        offset += count * size;
+        size = nextSize;
+    }
+
+    return tiers;
+}
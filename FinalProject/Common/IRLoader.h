@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "ConvolutionEngine.h"
+
+class IRLoader
+{
+public:
+    IRLoader();
+
+    // Longest IR accepted, in samples: about 6 hours at 48 kHz, whose fp32 spectra alone take
+    // 8 GB per path. File lengths are read as 64 bits, so longer files are refused, not wrapped.
+    static constexpr juce::int64 maxIRLength = juce::int64{ 1 } << 30;
+
+    // Files are decoded a partition at a time straight into the IR's spectra (WAV and AIFF
+    // through a memory mapping), so a load needs little more memory than the IRData it returns.
+    // Files go through the process-wide IRCache: loading a file that another instance already
+    // loaded with the same plan (block size and the settings below) returns the same IRData.
+    std::shared_ptr<const IRData> loadIR(const juce::File& file,
+                                         double sampleRate,
+                                         int blockSize);
+    // Same planning for an IR already in memory (one channel per path, as in a file); never cached.
+    // A buffer recorded at bufferSampleRate is resampled to sampleRate like a file; 0 means it is
+    // already at sampleRate.
+    std::shared_ptr<const IRData> loadIR(const juce::AudioBuffer<float>& irBuffer,
+                                         double sampleRate,
+                                         int blockSize,
+                                         double bufferSampleRate = 0.0);
+
+    // Convolve the first partition of the IR with a direct FIR so odd host block sizes cost no
+    // latency. Applies to IRs loaded afterwards; short IRs always use a pure FIR when it is cheaper.
+    void setZeroLatency(bool shouldUseDirectHead) { zeroLatency = shouldUseDirectHead; }
+    bool isZeroLatency() const { return zeroLatency; }
+
+    // Offline rendering: ignore the block size (and the zero-latency head) and use the uniform
+    // partition size with the lowest cost per sample for the IR, up to one partition for the whole
+    // IR. Applies to IRs loaded afterwards.
+    void setOfflinePlanning(bool shouldPlanForThroughput) { offlinePlanning = shouldPlanForThroughput; }
+    bool isOfflinePlanning() const { return offlinePlanning; }
+
+    // Store the IR spectra of tail tiers as fp16 or bf16 instead of fp32, halving their footprint
+    // and the memory traffic of their MAC. The head tier, and every tier starting before
+    // fullPrecisionLength IR samples, stays fp32. Applies to IRs loaded afterwards.
+    void setSpectrumFormat(ComplexMac::SpectrumFormat format, int fullPrecisionLength = 0)
+    {
+        spectrumFormat = format;
+        fullPrecisionSamples = std::max(0, fullPrecisionLength);
+    }
+    ComplexMac::SpectrumFormat getSpectrumFormat() const { return spectrumFormat; }
+
+    // File loads return as soon as the FIR head and the head tier are transformed; the remaining
+    // tiers are decoded and transformed on a process-wide thread and become audible partition by
+    // partition (IRData::readyPartitions). A fill outlives the loader that started it and stops
+    // only once nothing holds the IR. Applies to IRs loaded afterwards; in-memory IRs are always
+    // loaded in full.
+    void setProgressiveLoading(bool shouldLoadProgressively) { progressiveLoading = shouldLoadProgressively; }
+    bool isProgressiveLoading() const { return progressiveLoading; }
+
+    // Threads that decode and transform an IR's partitions, counting the loading thread itself;
+    // 0 (the default) uses one per core. Applies to IRs loaded afterwards.
+    void setNumLoadThreads(int numThreads) { numLoadThreads = std::max(0, numThreads); }
+    int getNumLoadThreads() const;
+
+private:
+    juce::AudioFormatManager formatManager;
+    std::atomic<bool> zeroLatency{ false };
+    std::atomic<bool> offlinePlanning{ false };
+    std::atomic<ComplexMac::SpectrumFormat> spectrumFormat{ ComplexMac::SpectrumFormat::fp32 };
+    std::atomic<int> fullPrecisionSamples{ 0 };
+    std::atomic<bool> progressiveLoading{ false };
+    std::atomic<int> numLoadThreads{ 0 };
+
+    // Helpers for loads in every loader of the process; the loading thread works alongside them.
+    // fillPool fills in progressively loaded IRs, handing each batch to pool. It belongs to the
+    // process rather than a loader because the IRs it fills are shared through IRCache; declared
+    // last so it stops before the jobs it hands out.
+    struct TransformThreads
+    {
+        juce::ThreadPool pool{ juce::ThreadPoolOptions{}.withThreadName("IR transform")
+                                   .withNumberOfThreads(std::max(1, juce::SystemStats::getNumCpus() - 1)) };
+        juce::ThreadPool fillPool{ juce::ThreadPoolOptions{}.withThreadName("IR loader").withNumberOfThreads(1) };
+    };
+    juce::SharedResourcePointer<TransformThreads> transformThreads;
+
+    // Head partition size and FIR head length for an IR of irLength samples.
+    struct HeadPlan
+    {
+        int partitionSize = 0;
+        int directLength = 0;
+    };
+
+    HeadPlan planHead(int irLength, int blockSize) const;
+    int computePartitionSize(int blockSize) const;
+    int computeOfflinePartitionSize(int irLength) const;
+    int computeFFTOrder(int fftSize) const;
+    bool prefersDirectConvolution(int irLength, int partitionSize) const;
+    std::vector<IRPartitionTier> planTiers(int headPartitionSize, int firstOffset, int irLength) const;
+    // Plans the tiers and picks their spectrum formats; spectra are allocated as tiers are filled.
+    std::shared_ptr<IRData> createIRData(int numPaths, int irLength, int blockSize) const;
+    // Memory-mapped reader for WAV and AIFF, a streaming one for anything else; null if the
+    // file cannot be read. Each load thread gets its own.
+    std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& file);
+    // Reversed copies of the first directLength samples of each path.
+    static void fillDirectTaps(IRData& data, const std::vector<const float*>& paths);
+};
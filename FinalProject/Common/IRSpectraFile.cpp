@@ -0,0 +1,371 @@
+#include "IRSpectraFile.h"
+#include "ConvolutionEngine.h"
+#include "RealFft.h"
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    constexpr char magic[8] = { 'C', 'V', 'I', 'R', 'S', 'P', 'E', 'C' };
+    constexpr std::uint32_t formatVersion = 3; // 2: IRs at another rate are resampled to the key's rate
+                                               // 3: the hash covers the header, tier table and FIR taps only
+    constexpr std::uint32_t byteOrderMark = 0x01020304;
+    constexpr std::uint64_t sectionAlignment = SpectrumBuffer::alignment;
+    constexpr int maxPaths = 4;
+    constexpr int maxTiers = 64;
+
+    // All records are laid out without padding so they can be written and compared byte for byte.
+    struct KeyRecord
+    {
+        std::uint64_t contentHash;
+        std::int64_t contentSize;
+        double sampleRate;
+        std::int32_t partitionSize;
+        std::int32_t fftOrder;
+        std::int32_t directLength;
+        std::int32_t offlinePlanning;
+        std::int32_t spectrumFormat;
+        std::int32_t fullPrecisionSamples;
+        std::int32_t fftBackend;
+        std::int32_t reserved;
+    };
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        KeyRecord key;
+        std::int32_t numPaths;
+        std::int32_t layout;
+        std::int32_t irLength;
+        std::int32_t directLength;
+        std::int32_t partitionSize;
+        std::int32_t numTiers;
+        std::uint64_t directTapsOffset; // numPaths * directLength floats
+        std::uint64_t fileSize;
+        std::uint64_t metadataHash;     // see getMetadataHash
+    };
+
+    struct TierRecord
+    {
+        std::int32_t partitionSize;
+        std::int32_t fftOrder;
+        std::int32_t fftSize;
+        std::int32_t numPartitions;
+        std::int32_t irOffset;
+        std::int32_t format;                    // ComplexMac::SpectrumFormat
+        std::uint64_t scalesOffset;             // compact tiers: numPaths * numPartitions floats
+        std::uint64_t spectraOffsets[maxPaths]; // one SpectrumBuffer layout per path
+    };
+
+    static_assert(std::is_trivially_copyable_v<FileHeader> && std::is_trivially_copyable_v<TierRecord>);
+    static_assert(sizeof(KeyRecord) == 56 && sizeof(FileHeader) == 120 && sizeof(TierRecord) == 64,
+                  "spectra file records must not contain padding");
+
+    KeyRecord makeKeyRecord(const IRCache::Key& key)
+    {
+        KeyRecord record{};
+        record.contentHash = key.contentHash;
+        record.contentSize = key.contentSize;
+        record.sampleRate = key.sampleRate;
+        record.partitionSize = key.partitionSize;
+        record.fftOrder = key.fftOrder;
+        record.directLength = key.directLength;
+        record.offlinePlanning = key.offlinePlanning ? 1 : 0;
+        record.spectrumFormat = static_cast<std::int32_t>(key.spectrumFormat);
+        record.fullPrecisionSamples = key.fullPrecisionSamples;
+        record.fftBackend = static_cast<std::int32_t>(key.fftBackend);
+        return record;
+    }
+
+    std::uint64_t alignUp(std::uint64_t offset) { return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment; }
+
+    bool isCompact(int format) { return format != static_cast<int>(ComplexMac::SpectrumFormat::fp32); }
+
+    std::uint64_t getSpectraBytes(int numPartitions, int fftSize, bool compact)
+    {
+        const int bins = fftSize / 2 + 1;
+        const auto stride = compact ? CompactSpectrumBuffer::getStrideFor(bins) : SpectrumBuffer::getStrideFor(bins);
+        const auto sampleSize = compact ? sizeof(std::uint16_t) : sizeof(float);
+        return static_cast<std::uint64_t>(numPartitions) * static_cast<std::uint64_t>(stride) * 2 * sampleSize;
+    }
+
+    // Hash of what a reader parses rather than maps: the header (with this hash zeroed), the tier
+    // table and the FIR taps, a few KB in all. The spectra are not hashed, so a cache hit does not
+    // read the whole file; they can only be damaged by something rewriting the file in place,
+    // since writers replace it atomically.
+    std::uint64_t getMetadataHash(FileHeader header, const void* tierTable, const void* directTaps, size_t directTapBytes)
+    {
+        header.metadataHash = 0;
+        IRCache::Hasher hasher;
+        hasher.add(&header, sizeof(header));
+        hasher.add(tierTable, static_cast<size_t>(header.numTiers) * sizeof(TierRecord));
+        hasher.add(directTaps, directTapBytes);
+        return hasher.get();
+    }
+
+    // Writes sections at increasing offsets, zero-filling the gaps.
+    class SectionWriter
+    {
+    public:
+        SectionWriter(juce::OutputStream& streamToUse, std::uint64_t startOffset)
+            : stream(streamToUse), position(startOffset)
+        {
+        }
+
+        bool write(std::uint64_t offset, const void* data, size_t numBytes)
+        {
+            static constexpr char zeros[sectionAlignment] = {};
+            while (position < offset)
+            {
+                const auto gap = static_cast<size_t>(std::min<std::uint64_t>(offset - position, sizeof(zeros)));
+                if (!put(zeros, gap))
+                    return false;
+            }
+            return put(data, numBytes);
+        }
+
+    private:
+        bool put(const void* data, size_t numBytes)
+        {
+            if (numBytes == 0)
+                return true;
+            position += numBytes;
+            return stream.write(data, numBytes);
+        }
+
+        juce::OutputStream& stream;
+        std::uint64_t position;
+    };
+
+    // Bounds and alignment check for a section of the mapped file.
+    bool isValidSection(std::uint64_t offset, std::uint64_t numBytes, std::uint64_t fileSize)
+    {
+        return offset % sectionAlignment == 0 && offset <= fileSize && numBytes <= fileSize - offset;
+    }
+}
+
+namespace IRSpectraFile
+{
+    juce::String getFileName(const IRCache::Key& key)
+    {
+        const auto record = makeKeyRecord(key);
+        IRCache::Hasher planHash;
+        planHash.add(&record, sizeof(record));
+
+        return juce::String::toHexString(static_cast<juce::int64>(key.contentHash)).paddedLeft('0', 16) + "-"
+               + juce::String::toHexString(static_cast<juce::int64>(planHash.get())).paddedLeft('0', 16) + ".irspectra";
+    }
+
+    bool write(const juce::File& file, const IRCache::Key& key, const IRData& ir)
+    {
+        const int numPaths = ir.numChannels;
+        if (numPaths < 1 || numPaths > maxPaths || ir.tiers.size() > static_cast<size_t>(maxTiers)
+            || (ir.directLength > 0 && ir.directTaps.size() != static_cast<size_t>(numPaths)) || !ir.isComplete())
+            return false;
+
+        // Lay out every section first; the tier table is written before the sections it points to.
+        FileHeader header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = formatVersion;
+        header.byteOrder = byteOrderMark;
+        header.key = makeKeyRecord(key);
+        header.numPaths = numPaths;
+        header.layout = static_cast<std::int32_t>(ir.layout);
+        header.irLength = ir.irLength;
+        header.directLength = ir.directLength;
+        header.partitionSize = ir.partitionSize;
+        header.numTiers = static_cast<std::int32_t>(ir.tiers.size());
+
+        std::vector<TierRecord> tierRecords(ir.tiers.size());
+        std::uint64_t offset = alignUp(sizeof(FileHeader));
+        offset = alignUp(offset + tierRecords.size() * sizeof(TierRecord));
+        header.directTapsOffset = offset;
+        offset = alignUp(offset + static_cast<std::uint64_t>(numPaths) * static_cast<std::uint64_t>(ir.directLength) * sizeof(float));
+
+        for (size_t t = 0; t < ir.tiers.size(); ++t)
+        {
+            const auto& tier = ir.tiers[t];
+            const bool compact = tier.format != ComplexMac::SpectrumFormat::fp32;
+            if ((compact ? tier.compactSpectra.size() : tier.spectra.size()) != static_cast<size_t>(numPaths))
+                return false;
+
+            auto& record = tierRecords[t];
+            record.partitionSize = tier.partitionSize;
+            record.fftOrder = tier.fftOrder;
+            record.fftSize = tier.fftSize;
+            record.numPartitions = tier.numPartitions;
+            record.irOffset = tier.irOffset;
+            record.format = static_cast<std::int32_t>(tier.format);
+
+            if (compact)
+            {
+                record.scalesOffset = offset;
+                offset = alignUp(offset + static_cast<std::uint64_t>(numPaths) * static_cast<std::uint64_t>(tier.numPartitions) * sizeof(float));
+            }
+
+            for (int path = 0; path < numPaths; ++path)
+            {
+                record.spectraOffsets[path] = offset;
+                offset = alignUp(offset + getSpectraBytes(tier.numPartitions, tier.fftSize, compact));
+            }
+        }
+        header.fileSize = offset;
+
+        std::vector<float> directTaps;
+        for (int path = 0; path < numPaths && ir.directLength > 0; ++path)
+            directTaps.insert(directTaps.end(), ir.directTaps[static_cast<size_t>(path)].begin(),
+                              ir.directTaps[static_cast<size_t>(path)].end());
+        header.metadataHash = getMetadataHash(header, tierRecords.data(), directTaps.data(), directTaps.size() * sizeof(float));
+
+        file.getParentDirectory().createDirectory();
+        juce::TemporaryFile temp(file);
+        {
+            juce::FileOutputStream stream(temp.getFile());
+            if (!stream.openedOk())
+                return false;
+
+            bool ok = stream.write(&header, sizeof(header));
+            SectionWriter payload(stream, sizeof(header));
+            ok = ok && payload.write(alignUp(sizeof(FileHeader)), tierRecords.data(), tierRecords.size() * sizeof(TierRecord));
+            ok = ok && payload.write(header.directTapsOffset, directTaps.data(), directTaps.size() * sizeof(float));
+
+            for (size_t t = 0; t < ir.tiers.size() && ok; ++t)
+            {
+                const auto& tier = ir.tiers[t];
+                const auto& record = tierRecords[t];
+                if (tier.format != ComplexMac::SpectrumFormat::fp32)
+                {
+                    for (int path = 0; path < numPaths && ok; ++path)
+                        ok = payload.write(record.scalesOffset + static_cast<std::uint64_t>(path) * tier.numPartitions * sizeof(float),
+                                           tier.compactScales[static_cast<size_t>(path)].data(), static_cast<size_t>(tier.numPartitions) * sizeof(float));
+                    for (int path = 0; path < numPaths && ok; ++path)
+                    {
+                        const auto& spectra = tier.compactSpectra[static_cast<size_t>(path)];
+                        ok = payload.write(record.spectraOffsets[path], spectra.real(0), spectra.getSizeInBytes());
+                    }
+                }
+                else
+                {
+                    for (int path = 0; path < numPaths && ok; ++path)
+                    {
+                        const auto& spectra = tier.spectra[static_cast<size_t>(path)];
+                        ok = payload.write(record.spectraOffsets[path], spectra.real(0), spectra.getSizeInBytes());
+                    }
+                }
+            }
+
+            static constexpr char noBytes[1] = {};
+            ok = ok && payload.write(header.fileSize, noBytes, 0);
+            stream.flush();
+            if (!ok || stream.getStatus().failed())
+                return false;
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+
+    std::shared_ptr<const IRData> read(const juce::File& file, const IRCache::Key& key)
+    {
+        if (!file.existsAsFile())
+            return nullptr;
+
+        auto mapping = std::make_shared<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+        const auto* bytes = static_cast<const char*>(mapping->getData());
+        const auto fileSize = static_cast<std::uint64_t>(mapping->getSize());
+        if (bytes == nullptr || fileSize < sizeof(FileHeader))
+            return nullptr;
+
+        FileHeader header;
+        std::memcpy(&header, bytes, sizeof(header));
+        const auto expectedKey = makeKeyRecord(key);
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != formatVersion
+            || header.byteOrder != byteOrderMark || std::memcmp(&header.key, &expectedKey, sizeof(expectedKey)) != 0
+            || header.fileSize != fileSize)
+            return nullptr;
+
+        const int numPaths = header.numPaths;
+        if (numPaths < 1 || numPaths > maxPaths || header.numTiers < 0 || header.numTiers > maxTiers
+            || header.irLength <= 0 || header.directLength < 0 || header.directLength > header.irLength)
+            return nullptr;
+
+        const auto tableOffset = alignUp(sizeof(FileHeader));
+        const auto directBytes = static_cast<std::uint64_t>(numPaths) * static_cast<std::uint64_t>(header.directLength) * sizeof(float);
+        if (!isValidSection(tableOffset, static_cast<std::uint64_t>(header.numTiers) * sizeof(TierRecord), fileSize)
+            || !isValidSection(header.directTapsOffset, directBytes, fileSize)
+            || getMetadataHash(header, bytes + tableOffset, bytes + header.directTapsOffset, static_cast<size_t>(directBytes)) != header.metadataHash)
+            return nullptr;
+
+        auto data = std::make_shared<IRData>();
+        data->numChannels = numPaths;
+        data->layout = header.layout == static_cast<std::int32_t>(IRData::Layout::trueStereo) ? IRData::Layout::trueStereo
+                                                                                            : IRData::Layout::perChannel;
+        data->irLength = header.irLength;
+        data->directLength = header.directLength;
+        data->partitionSize = header.partitionSize;
+
+        // The FIR taps and fp16 scales are small and copied; the spectra stay in the mapping.
+        const auto* taps = reinterpret_cast<const float*>(bytes + header.directTapsOffset);
+        if (header.directLength > 0)
+            for (int path = 0; path < numPaths; ++path)
+                data->directTaps.emplace_back(taps + path * header.directLength, taps + (path + 1) * header.directLength);
+
+        data->tiers.resize(static_cast<size_t>(header.numTiers));
+        for (int t = 0; t < header.numTiers; ++t)
+        {
+            TierRecord record;
+            std::memcpy(&record, bytes + tableOffset + static_cast<std::uint64_t>(t) * sizeof(TierRecord), sizeof(record));
+
+            const bool compact = isCompact(record.format);
+            if (record.numPartitions <= 0 || record.fftOrder < RealFft::minOrder || record.fftOrder > RealFft::maxOrder
+                || record.fftSize != (1 << record.fftOrder) || record.partitionSize * 2 != record.fftSize
+                || record.format < 0 || record.format > static_cast<std::int32_t>(ComplexMac::SpectrumFormat::bf16))
+                return nullptr;
+
+            auto& tier = data->tiers[static_cast<size_t>(t)];
+            tier.partitionSize = record.partitionSize;
+            tier.fftOrder = record.fftOrder;
+            tier.fftSize = record.fftSize;
+            tier.numPartitions = record.numPartitions;
+            tier.irOffset = record.irOffset;
+            tier.firstPartition = data->totalPartitions;
+            tier.format = static_cast<ComplexMac::SpectrumFormat>(record.format);
+            data->totalPartitions += record.numPartitions;
+
+            const auto spectraBytes = getSpectraBytes(record.numPartitions, record.fftSize, compact);
+            for (int path = 0; path < numPaths; ++path)
+                if (!isValidSection(record.spectraOffsets[path], spectraBytes, fileSize))
+                    return nullptr;
+
+            const int bins = record.fftSize / 2 + 1;
+            if (compact)
+            {
+                const auto scaleCount = static_cast<std::uint64_t>(record.numPartitions);
+                if (!isValidSection(record.scalesOffset, numPaths * scaleCount * sizeof(float), fileSize))
+                    return nullptr;
+
+                const auto* scales = reinterpret_cast<const float*>(bytes + record.scalesOffset);
+                tier.compactSpectra.resize(static_cast<size_t>(numPaths));
+                for (int path = 0; path < numPaths; ++path)
+                {
+                    tier.compactScales.emplace_back(scales + path * scaleCount, scales + (path + 1) * scaleCount);
+                    tier.compactSpectra[static_cast<size_t>(path)].attach(
+                        reinterpret_cast<const std::uint16_t*>(bytes + record.spectraOffsets[path]), record.numPartitions, bins);
+                }
+            }
+            else
+            {
+                tier.spectra.resize(static_cast<size_t>(numPaths));
+                for (int path = 0; path < numPaths; ++path)
+                    tier.spectra[static_cast<size_t>(path)].attach(
+                        reinterpret_cast<const float*>(bytes + record.spectraOffsets[path]), record.numPartitions, bins);
+            }
+        }
+
+        data->readyPartitions.store(data->totalPartitions, std::memory_order_release);
+        data->externalStorage = std::move(mapping);
+        return data;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <juce_core/juce_core.h>
+#include "IRCache.h"
+
+// On-disk form of a complete IRData, used by IRCache so a session reopens without decoding and
+// transforming its IRs again. A file is a fixed header (magic, format version, byte order, the
+// full IRCache::Key and the IR's shape), a table of tiers, the FIR head taps, and then every
+// tier's spectra in exactly the SpectrumBuffer layout, each section 64-byte aligned. Reading maps
+// the file and attaches the tiers' spectra to the mapping, so they are never copied.
+//
+// A file whose version, byte order, key or size does not match, or whose hash of the header, tier
+// table and FIR taps is wrong, is rejected, and the caller rebuilds and rewrites it. The spectra
+// are not hashed, so a hit does not read them all. Files are written to a temporary file and
+// moved into place, so a reader never sees half a file.
+namespace IRSpectraFile
+{
+    // Name of the cache file for key, unique per content hash and plan.
+    juce::String getFileName(const IRCache::Key& key);
+
+    // Returns false (leaving any existing file alone) if the file could not be written or the IR
+    // is still being loaded.
+    bool write(const juce::File& file, const IRCache::Key& key, const IRData& ir);
+
+    // Null if the file is missing, stale or damaged.
+    std::shared_ptr<const IRData> read(const juce::File& file, const IRCache::Key& key);
+}
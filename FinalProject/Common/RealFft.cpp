@@ -0,0 +1,419 @@
+#include "RealFft.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
+#include "ComplexMac.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+ #define CONVOLUTION_FFT_X86 1
+ #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+ #define CONVOLUTION_FFT_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+ #define CONVOLUTION_FFT_TARGET(isa) __attribute__((target(isa)))
+#else
+ #define CONVOLUTION_FFT_TARGET(isa)
+#endif
+
+namespace
+{
+    // One radix-4 pass: the stages with butterfly spans 2h and 4h in one sweep, so each group of
+    // four points is loaded and stored once. The second stage's twiddle for the upper quarter is
+    // the lower one times -i, which costs only a swap and a negation.
+    void radix4PassScalar(float* re, float* im, const float* w1r, const float* w1i,
+                          const float* w2r, const float* w2i, int h, int half) noexcept
+    {
+        for (int g = 0; g < half; g += 4 * h)
+        {
+            float* r0 = re + g;
+            float* i0 = im + g;
+            float* r1 = r0 + h;
+            float* i1 = i0 + h;
+            float* r2 = r1 + h;
+            float* i2 = i1 + h;
+            float* r3 = r2 + h;
+            float* i3 = i2 + h;
+
+            for (int j = 0; j < h; ++j)
+            {
+                const float c1r = w1r[j], c1i = w1i[j];
+                const float t1r = c1r * r1[j] - c1i * i1[j];
+                const float t1i = c1r * i1[j] + c1i * r1[j];
+                const float t3r = c1r * r3[j] - c1i * i3[j];
+                const float t3i = c1r * i3[j] + c1i * r3[j];
+
+                const float b0r = r0[j] + t1r, b0i = i0[j] + t1i;
+                const float b1r = r0[j] - t1r, b1i = i0[j] - t1i;
+                const float b2r = r2[j] + t3r, b2i = i2[j] + t3i;
+                const float b3r = r2[j] - t3r, b3i = i2[j] - t3i;
+
+                const float c2r = w2r[j], c2i = w2i[j];
+                const float u2r = c2r * b2r - c2i * b2i;
+                const float u2i = c2r * b2i + c2i * b2r;
+                const float u3r = c2r * b3i + c2i * b3r;   // -i * (w2 * b3), real part
+                const float u3i = c2i * b3i - c2r * b3r;   // -i * (w2 * b3), imaginary part
+
+                r0[j] = b0r + u2r;
+                i0[j] = b0i + u2i;
+                r2[j] = b0r - u2r;
+                i2[j] = b0i - u2i;
+                r1[j] = b1r + u3r;
+                i1[j] = b1i + u3i;
+                r3[j] = b1r - u3r;
+                i3[j] = b1i - u3i;
+            }
+        }
+    }
+
+    // The vector passes run the same butterflies on 4/8 adjacent j at once. Split planes make that
+    // plain loads and stores with no shuffles; passes with h below the vector width stay scalar.
+#if CONVOLUTION_FFT_X86
+    CONVOLUTION_FFT_TARGET("sse2")
+    void radix4PassSse2(float* re, float* im, const float* w1r, const float* w1i,
+                        const float* w2r, const float* w2i, int h, int half) noexcept
+    {
+        if (h < 4)
+            return radix4PassScalar(re, im, w1r, w1i, w2r, w2i, h, half);
+
+        for (int g = 0; g < half; g += 4 * h)
+        {
+            float* r0 = re + g;
+            float* i0 = im + g;
+
+            for (int j = 0; j < h; j += 4)
+            {
+                const __m128 c1r = _mm_loadu_ps(w1r + j), c1i = _mm_loadu_ps(w1i + j);
+                const __m128 c2r = _mm_loadu_ps(w2r + j), c2i = _mm_loadu_ps(w2i + j);
+                const __m128 x0r = _mm_loadu_ps(r0 + j), x0i = _mm_loadu_ps(i0 + j);
+                const __m128 x1r = _mm_loadu_ps(r0 + h + j), x1i = _mm_loadu_ps(i0 + h + j);
+                const __m128 x2r = _mm_loadu_ps(r0 + 2 * h + j), x2i = _mm_loadu_ps(i0 + 2 * h + j);
+                const __m128 x3r = _mm_loadu_ps(r0 + 3 * h + j), x3i = _mm_loadu_ps(i0 + 3 * h + j);
+
+                const __m128 t1r = _mm_sub_ps(_mm_mul_ps(c1r, x1r), _mm_mul_ps(c1i, x1i));
+                const __m128 t1i = _mm_add_ps(_mm_mul_ps(c1r, x1i), _mm_mul_ps(c1i, x1r));
+                const __m128 t3r = _mm_sub_ps(_mm_mul_ps(c1r, x3r), _mm_mul_ps(c1i, x3i));
+                const __m128 t3i = _mm_add_ps(_mm_mul_ps(c1r, x3i), _mm_mul_ps(c1i, x3r));
+
+                const __m128 b0r = _mm_add_ps(x0r, t1r), b0i = _mm_add_ps(x0i, t1i);
+                const __m128 b1r = _mm_sub_ps(x0r, t1r), b1i = _mm_sub_ps(x0i, t1i);
+                const __m128 b2r = _mm_add_ps(x2r, t3r), b2i = _mm_add_ps(x2i, t3i);
+                const __m128 b3r = _mm_sub_ps(x2r, t3r), b3i = _mm_sub_ps(x2i, t3i);
+
+                const __m128 u2r = _mm_sub_ps(_mm_mul_ps(c2r, b2r), _mm_mul_ps(c2i, b2i));
+                const __m128 u2i = _mm_add_ps(_mm_mul_ps(c2r, b2i), _mm_mul_ps(c2i, b2r));
+                const __m128 u3r = _mm_add_ps(_mm_mul_ps(c2r, b3i), _mm_mul_ps(c2i, b3r));
+                const __m128 u3i = _mm_sub_ps(_mm_mul_ps(c2i, b3i), _mm_mul_ps(c2r, b3r));
+
+                _mm_storeu_ps(r0 + j, _mm_add_ps(b0r, u2r));
+                _mm_storeu_ps(i0 + j, _mm_add_ps(b0i, u2i));
+                _mm_storeu_ps(r0 + 2 * h + j, _mm_sub_ps(b0r, u2r));
+                _mm_storeu_ps(i0 + 2 * h + j, _mm_sub_ps(b0i, u2i));
+                _mm_storeu_ps(r0 + h + j, _mm_add_ps(b1r, u3r));
+                _mm_storeu_ps(i0 + h + j, _mm_add_ps(b1i, u3i));
+                _mm_storeu_ps(r0 + 3 * h + j, _mm_sub_ps(b1r, u3r));
+                _mm_storeu_ps(i0 + 3 * h + j, _mm_sub_ps(b1i, u3i));
+            }
+        }
+    }
+
+    CONVOLUTION_FFT_TARGET("avx2,fma")
+    void radix4PassAvx2(float* re, float* im, const float* w1r, const float* w1i,
+                        const float* w2r, const float* w2i, int h, int half) noexcept
+    {
+        if (h < 8)
+            return radix4PassSse2(re, im, w1r, w1i, w2r, w2i, h, half);
+
+        for (int g = 0; g < half; g += 4 * h)
+        {
+            float* r0 = re + g;
+            float* i0 = im + g;
+
+            for (int j = 0; j < h; j += 8)
+            {
+                const __m256 c1r = _mm256_loadu_ps(w1r + j), c1i = _mm256_loadu_ps(w1i + j);
+                const __m256 c2r = _mm256_loadu_ps(w2r + j), c2i = _mm256_loadu_ps(w2i + j);
+                const __m256 x0r = _mm256_loadu_ps(r0 + j), x0i = _mm256_loadu_ps(i0 + j);
+                const __m256 x1r = _mm256_loadu_ps(r0 + h + j), x1i = _mm256_loadu_ps(i0 + h + j);
+                const __m256 x2r = _mm256_loadu_ps(r0 + 2 * h + j), x2i = _mm256_loadu_ps(i0 + 2 * h + j);
+                const __m256 x3r = _mm256_loadu_ps(r0 + 3 * h + j), x3i = _mm256_loadu_ps(i0 + 3 * h + j);
+
+                const __m256 t1r = _mm256_fmsub_ps(c1r, x1r, _mm256_mul_ps(c1i, x1i));
+                const __m256 t1i = _mm256_fmadd_ps(c1r, x1i, _mm256_mul_ps(c1i, x1r));
+                const __m256 t3r = _mm256_fmsub_ps(c1r, x3r, _mm256_mul_ps(c1i, x3i));
+                const __m256 t3i = _mm256_fmadd_ps(c1r, x3i, _mm256_mul_ps(c1i, x3r));
+
+                const __m256 b0r = _mm256_add_ps(x0r, t1r), b0i = _mm256_add_ps(x0i, t1i);
+                const __m256 b1r = _mm256_sub_ps(x0r, t1r), b1i = _mm256_sub_ps(x0i, t1i);
+                const __m256 b2r = _mm256_add_ps(x2r, t3r), b2i = _mm256_add_ps(x2i, t3i);
+                const __m256 b3r = _mm256_sub_ps(x2r, t3r), b3i = _mm256_sub_ps(x2i, t3i);
+
+                const __m256 u2r = _mm256_fmsub_ps(c2r, b2r, _mm256_mul_ps(c2i, b2i));
+                const __m256 u2i = _mm256_fmadd_ps(c2r, b2i, _mm256_mul_ps(c2i, b2r));
+                const __m256 u3r = _mm256_fmadd_ps(c2r, b3i, _mm256_mul_ps(c2i, b3r));
+                const __m256 u3i = _mm256_fmsub_ps(c2i, b3i, _mm256_mul_ps(c2r, b3r));
+
+                _mm256_storeu_ps(r0 + j, _mm256_add_ps(b0r, u2r));
+                _mm256_storeu_ps(i0 + j, _mm256_add_ps(b0i, u2i));
+                _mm256_storeu_ps(r0 + 2 * h + j, _mm256_sub_ps(b0r, u2r));
+                _mm256_storeu_ps(i0 + 2 * h + j, _mm256_sub_ps(b0i, u2i));
+                _mm256_storeu_ps(r0 + h + j, _mm256_add_ps(b1r, u3r));
+                _mm256_storeu_ps(i0 + h + j, _mm256_add_ps(b1i, u3i));
+                _mm256_storeu_ps(r0 + 3 * h + j, _mm256_sub_ps(b1r, u3r));
+                _mm256_storeu_ps(i0 + 3 * h + j, _mm256_sub_ps(b1i, u3i));
+            }
+        }
+    }
+#endif
+
+#if CONVOLUTION_FFT_NEON
+    void radix4PassNeon(float* re, float* im, const float* w1r, const float* w1i,
+                        const float* w2r, const float* w2i, int h, int half) noexcept
+    {
+        if (h < 4)
+            return radix4PassScalar(re, im, w1r, w1i, w2r, w2i, h, half);
+
+        for (int g = 0; g < half; g += 4 * h)
+        {
+            float* r0 = re + g;
+            float* i0 = im + g;
+
+            for (int j = 0; j < h; j += 4)
+            {
+                const float32x4_t c1r = vld1q_f32(w1r + j), c1i = vld1q_f32(w1i + j);
+                const float32x4_t c2r = vld1q_f32(w2r + j), c2i = vld1q_f32(w2i + j);
+                const float32x4_t x0r = vld1q_f32(r0 + j), x0i = vld1q_f32(i0 + j);
+                const float32x4_t x1r = vld1q_f32(r0 + h + j), x1i = vld1q_f32(i0 + h + j);
+                const float32x4_t x2r = vld1q_f32(r0 + 2 * h + j), x2i = vld1q_f32(i0 + 2 * h + j);
+                const float32x4_t x3r = vld1q_f32(r0 + 3 * h + j), x3i = vld1q_f32(i0 + 3 * h + j);
+
+                const float32x4_t t1r = vfmsq_f32(vmulq_f32(c1r, x1r), c1i, x1i);
+                const float32x4_t t1i = vfmaq_f32(vmulq_f32(c1r, x1i), c1i, x1r);
+                const float32x4_t t3r = vfmsq_f32(vmulq_f32(c1r, x3r), c1i, x3i);
+                const float32x4_t t3i = vfmaq_f32(vmulq_f32(c1r, x3i), c1i, x3r);
+
+                const float32x4_t b0r = vaddq_f32(x0r, t1r), b0i = vaddq_f32(x0i, t1i);
+                const float32x4_t b1r = vsubq_f32(x0r, t1r), b1i = vsubq_f32(x0i, t1i);
+                const float32x4_t b2r = vaddq_f32(x2r, t3r), b2i = vaddq_f32(x2i, t3i);
+                const float32x4_t b3r = vsubq_f32(x2r, t3r), b3i = vsubq_f32(x2i, t3i);
+
+                const float32x4_t u2r = vfmsq_f32(vmulq_f32(c2r, b2r), c2i, b2i);
+                const float32x4_t u2i = vfmaq_f32(vmulq_f32(c2r, b2i), c2i, b2r);
+                const float32x4_t u3r = vfmaq_f32(vmulq_f32(c2r, b3i), c2i, b3r);
+                const float32x4_t u3i = vfmsq_f32(vmulq_f32(c2i, b3i), c2r, b3r);
+
+                vst1q_f32(r0 + j, vaddq_f32(b0r, u2r));
+                vst1q_f32(i0 + j, vaddq_f32(b0i, u2i));
+                vst1q_f32(r0 + 2 * h + j, vsubq_f32(b0r, u2r));
+                vst1q_f32(i0 + 2 * h + j, vsubq_f32(b0i, u2i));
+                vst1q_f32(r0 + h + j, vaddq_f32(b1r, u3r));
+                vst1q_f32(i0 + h + j, vaddq_f32(b1i, u3i));
+                vst1q_f32(r0 + 3 * h + j, vsubq_f32(b1r, u3r));
+                vst1q_f32(i0 + 3 * h + j, vsubq_f32(b1i, u3i));
+            }
+        }
+    }
+#endif
+
+    RealFft::PassKernel getPassKernel(RealFft::Variant variant)
+    {
+        if (variant == RealFft::Variant::scalar)
+            return radix4PassScalar;
+
+        // The vector variant follows the MAC's runtime ISA choice; AVX-512 machines use AVX2.
+        switch (ComplexMac::getActiveIsa())
+        {
+           #if CONVOLUTION_FFT_X86
+            case ComplexMac::Isa::sse2:   return radix4PassSse2;
+            case ComplexMac::Isa::avx2:
+            case ComplexMac::Isa::avx512: return radix4PassAvx2;
+           #endif
+           #if CONVOLUTION_FFT_NEON
+            case ComplexMac::Isa::neon:   return radix4PassNeon;
+           #endif
+            default:                      return radix4PassScalar;
+        }
+    }
+}
+
+std::shared_ptr<const RealFft> RealFft::getPlan(int order, Variant variant)
+{
+    static std::mutex cacheMutex;
+    static std::array<std::array<std::shared_ptr<const RealFft>, maxOrder + 1>, 2> cache;
+
+    order = std::clamp(order, minOrder, maxOrder);
+
+    const std::lock_guard<std::mutex> lock(cacheMutex);
+    auto& plan = cache[variant == Variant::scalar ? 0 : 1][static_cast<size_t>(order)];
+    if (plan == nullptr)
+        plan = std::make_shared<const RealFft>(order, variant);
+    return plan;
+}
+
+RealFft::RealFft(int fftOrder, Variant planVariant)
+    : order(std::clamp(fftOrder, minOrder, maxOrder)),
+      size(1 << order),
+      half(size / 2),
+      variant(planVariant),
+      radix4Pass(getPassKernel(planVariant))
+{
+    const double pi = 3.14159265358979323846;
+
+    // Bit reversal over log2(half) bits, stored as the swaps that actually move something.
+    const int bits = order - 1;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(half); ++i)
+    {
+        uint32_t j = 0;
+        for (int b = 0; b < bits; ++b)
+            j |= ((i >> b) & 1u) << (bits - 1 - b);
+        if (i < j)
+        {
+            bitReverseSwaps.push_back(i);
+            bitReverseSwaps.push_back(j);
+        }
+    }
+
+    // Twiddles in double precision so the tables carry no accumulated rounding.
+    stageRe.resize(static_cast<size_t>(std::max(1, half - 1)));
+    stageIm.resize(stageRe.size());
+    for (int h = 1; h < half; h *= 2)
+        for (int j = 0; j < h; ++j)
+        {
+            const double angle = -pi * j / h;
+            stageRe[static_cast<size_t>(h - 1 + j)] = static_cast<float>(std::cos(angle));
+            stageIm[static_cast<size_t>(h - 1 + j)] = static_cast<float>(std::sin(angle));
+        }
+
+    packRe.resize(static_cast<size_t>(half / 2 + 1));
+    packIm.resize(packRe.size());
+    for (int k = 0; k <= half / 2; ++k)
+    {
+        const double angle = -2.0 * pi * k / size;
+        packRe[static_cast<size_t>(k)] = static_cast<float>(std::cos(angle));
+        packIm[static_cast<size_t>(k)] = static_cast<float>(std::sin(angle));
+    }
+}
+
+void RealFft::forward(const float* input, int numInput, float* real, float* imag) const noexcept
+{
+    // Pack even samples into the real plane and odd samples into the imaginary plane.
+    const int count = std::clamp(numInput, 0, size);
+    const int pairs = count / 2;
+    for (int m = 0; m < pairs; ++m)
+    {
+        real[m] = input[2 * m];
+        imag[m] = input[2 * m + 1];
+    }
+    std::fill(real + pairs, real + half, 0.0f);
+    std::fill(imag + pairs, imag + half, 0.0f);
+    if ((count & 1) != 0)
+        real[pairs] = input[count - 1];
+
+    transform(real, imag);
+
+    // Untangle Z[k] into X[k] = E[k] + W^k O[k], where E and O are the spectra of the even and odd
+    // samples. X[half - k] = conj(E[k] - W^k O[k]) comes from the same pair of bins.
+    const float z0r = real[0];
+    const float z0i = imag[0];
+    real[0] = z0r + z0i;
+    imag[0] = 0.0f;
+    real[half] = z0r - z0i;
+    imag[half] = 0.0f;
+
+    for (int k = 1; k <= half / 2; ++k)
+    {
+        const int m = half - k;
+        const float zkr = real[k], zki = imag[k];
+        const float zmr = real[m], zmi = imag[m];
+
+        const float er = 0.5f * (zkr + zmr);
+        const float ei = 0.5f * (zki - zmi);
+        const float orr = 0.5f * (zki + zmi);
+        const float oi = -0.5f * (zkr - zmr);
+
+        const float wr = packRe[static_cast<size_t>(k)];
+        const float wi = packIm[static_cast<size_t>(k)];
+        const float tr = wr * orr - wi * oi;
+        const float ti = wr * oi + wi * orr;
+
+        real[k] = er + tr;
+        imag[k] = ei + ti;
+        real[m] = er - tr;
+        imag[m] = ti - ei;
+    }
+}
+
+void RealFft::inverse(const float* real, const float* imag, float* output, float* work, float scale) const noexcept
+{
+    float* zr = work;
+    float* zi = work + half;
+
+    // Rebuild Z'[k] = E'[k] + i O'[k] with E' = X[k] + conj(X[half - k]) and
+    // O' = conj(W^k) (X[k] - conj(X[half - k])): twice the packed spectrum, so the output comes out
+    // at N times the input like every other unnormalised inverse in the engines.
+    zr[0] = real[0] + real[half];
+    zi[0] = real[0] - real[half];
+
+    for (int k = 1; k <= half / 2; ++k)
+    {
+        const int m = half - k;
+        const float er = real[k] + real[m];
+        const float ei = imag[k] - imag[m];
+        const float dr = real[k] - real[m];
+        const float di = imag[k] + imag[m];
+
+        const float wr = packRe[static_cast<size_t>(k)];
+        const float wi = packIm[static_cast<size_t>(k)];
+        const float orr = wr * dr + wi * di;
+        const float oi = wr * di - wi * dr;
+
+        zr[k] = er - oi;
+        zi[k] = ei + orr;
+        zr[m] = er + oi;
+        zi[m] = orr - ei;
+    }
+
+    // Swapping the planes turns the forward transform into the inverse one.
+    transform(zi, zr);
+
+    for (int m = 0; m < half; ++m)
+    {
+        output[2 * m] = zr[m] * scale;
+        output[2 * m + 1] = zi[m] * scale;
+    }
+}
+
+void RealFft::transform(float* re, float* im) const noexcept
+{
+    for (size_t s = 0; s < bitReverseSwaps.size(); s += 2)
+    {
+        const uint32_t a = bitReverseSwaps[s];
+        const uint32_t b = bitReverseSwaps[s + 1];
+        std::swap(re[a], re[b]);
+        std::swap(im[a], im[b]);
+    }
+
+    int h = 1;
+
+    // An odd number of radix-2 stages leaves one to run on its own; its twiddles are all 1.
+    if (((order - 1) & 1) != 0)
+    {
+        for (int i = 0; i < half; i += 2)
+        {
+            const float ar = re[i], ai = im[i];
+            const float br = re[i + 1], bi = im[i + 1];
+            re[i] = ar + br;
+            im[i] = ai + bi;
+            re[i + 1] = ar - br;
+            im[i + 1] = ai - bi;
+        }
+        h = 2;
+    }
+
+    for (; h < half; h *= 4)
+        radix4Pass(re, im, stageRe.data() + (h - 1), stageIm.data() + (h - 1),
+                   stageRe.data() + (2 * h - 1), stageIm.data() + (2 * h - 1), h, half);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Planned FFT for real signals of size N = 2^order, producing and consuming split half spectra
+// (N / 2 + 1 bins, real and imaginary planes in separate arrays):
+//
+//     forward:  X[k] = sum_n x[n] * exp(-2*pi*i*k*n / N)    for k in [0, N/2]
+//     inverse:  x[n] = sum_k X[k] * exp(+2*pi*i*k*n / N)    (unnormalised, i.e. N times the input)
+//
+// The real input is packed as N/2 complex samples (even samples real, odd samples imaginary), run
+// through an N/2-point complex FFT and untangled with one extra twiddle pass, which halves the
+// transform work. The complex FFT works in place on split planes: a precomputed bit-reversal swap
+// list, then radix-4 passes (two radix-2 stages fused per sweep) with one radix-2 pass first when
+// log2(N/2) is odd. Every pass reads its twiddles from its own contiguous table. The `simd` variant
+// runs the radix-4 passes with SSE2/AVX2+FMA/NEON butterflies over 4 or 8 adjacent points, picked
+// at runtime like ComplexMac; it differs from `scalar` only by rounding.
+//
+// Plans are immutable once built, so one plan per order is cached for the whole process and shared
+// by every engine instance and thread; each caller supplies its own work buffer.
+class RealFft
+{
+public:
+    static constexpr int minOrder = 2;
+    static constexpr int maxOrder = 24;
+
+    enum class Variant
+    {
+        scalar,
+        simd
+    };
+
+    using PassKernel = void (*)(float* re, float* im, const float* w1r, const float* w1i,
+                                const float* w2r, const float* w2i, int h, int half) noexcept;
+
+    // Shared plan for size 2^order, built on first use. Allocates and locks, so call it from
+    // prepare()/IR loading rather than the audio thread.
+    static std::shared_ptr<const RealFft> getPlan(int order, Variant variant = Variant::scalar);
+
+    explicit RealFft(int order, Variant variant = Variant::scalar);
+
+    int getOrder() const noexcept { return order; }
+    int getSize() const noexcept { return size; }
+    int getNumBins() const noexcept { return size / 2 + 1; }
+    Variant getVariant() const noexcept { return variant; }
+
+    // Floats of caller-owned scratch that inverse() needs.
+    int getWorkSize() const noexcept { return size; }
+
+    // Transforms `numInput` samples zero-padded to N. `real` and `imag` need N/2 + 1 floats each.
+    void forward(const float* input, int numInput, float* real, float* imag) const noexcept;
+
+    // Writes N samples times `scale` to `output`; the spectrum is left untouched.
+    void inverse(const float* real, const float* imag, float* output, float* work, float scale = 1.0f) const noexcept;
+
+private:
+    void transform(float* re, float* im) const noexcept;
+
+    int order = 0;
+    int size = 0;
+    int half = 0; // complex FFT size, N / 2
+    Variant variant = Variant::scalar;
+    PassKernel radix4Pass = nullptr;
+
+    std::vector<uint32_t> bitReverseSwaps;    // pairs (i, j) with i < j
+    std::vector<float> stageRe, stageIm;      // stage with butterfly span 2h at offset h - 1: exp(-i*pi*j/h), j < h
+    std::vector<float> packRe, packIm;        // exp(-2*pi*i*k/N), k <= N/4
+};
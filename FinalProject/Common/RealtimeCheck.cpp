@@ -0,0 +1,222 @@
+#include "RealtimeCheck.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if CONVOLUTION_REALTIME_CHECK
+
+#if defined(__linux__) || defined(__APPLE__)
+ #include <execinfo.h>
+ #define CONVOLUTION_REALTIME_CHECK_STACKS 1
+#endif
+
+#if defined(__linux__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #define CONVOLUTION_REALTIME_CHECK_MUTEX 1
+#endif
+
+namespace
+{
+    constexpr int maxRecords = 32;
+    constexpr int maxFrames = 24;
+
+    struct Record
+    {
+        RealtimeCheck::Violation violation = RealtimeCheck::Violation::allocation;
+        std::size_t size = 0;
+        void* frames[maxFrames] = {};
+        int numFrames = 0;
+    };
+
+    // Fixed storage claimed through an atomic counter, so recording works from any thread
+    // without allocating or locking.
+    Record records[maxRecords];
+    std::atomic<int> numViolations{ 0 };
+
+    thread_local int realtimeDepth = 0;
+    thread_local bool recording = false; // a hook is running; calls it makes itself are not checked
+
+    void record(RealtimeCheck::Violation violation, std::size_t size) noexcept
+    {
+        if (realtimeDepth == 0 || recording)
+            return;
+
+        recording = true;
+        const int index = numViolations.fetch_add(1, std::memory_order_relaxed);
+        if (index < maxRecords)
+        {
+            auto& entry = records[index];
+            entry.violation = violation;
+            entry.size = size;
+#if CONVOLUTION_REALTIME_CHECK_STACKS
+            entry.numFrames = backtrace(entry.frames, maxFrames);
+#endif
+        }
+        recording = false;
+    }
+
+    void* allocate(std::size_t size)
+    {
+        record(RealtimeCheck::Violation::allocation, size);
+        if (void* memory = std::malloc(size == 0 ? 1 : size))
+            return memory;
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        record(RealtimeCheck::Violation::allocation, size);
+        const auto align = static_cast<std::size_t>(alignment);
+        void* memory = nullptr;
+#if defined(_MSC_VER)
+        memory = _aligned_malloc(size == 0 ? align : size, align);
+#else
+        if (posix_memalign(&memory, std::max(align, sizeof(void*)), size == 0 ? align : size) != 0)
+            memory = nullptr;
+#endif
+        if (memory == nullptr)
+            throw std::bad_alloc();
+        return memory;
+    }
+
+    void release(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            record(RealtimeCheck::Violation::deallocation, 0);
+        std::free(memory);
+    }
+
+    void releaseAligned(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            record(RealtimeCheck::Violation::deallocation, 0);
+#if defined(_MSC_VER)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+
+    const char* getName(RealtimeCheck::Violation violation)
+    {
+        switch (violation)
+        {
+            case RealtimeCheck::Violation::allocation:   return "allocation";
+            case RealtimeCheck::Violation::deallocation: return "deallocation";
+            case RealtimeCheck::Violation::mutexLock:    return "mutex lock";
+        }
+        return "?";
+    }
+
+    struct Warmup
+    {
+        Warmup()
+        {
+#if CONVOLUTION_REALTIME_CHECK_STACKS
+            // The first backtrace() loads the unwinder, which allocates; get that out of the way.
+            void* frames[2];
+            backtrace(frames, 2);
+#endif
+        }
+    } warmup;
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { release(memory); }
+void operator delete[](void* memory) noexcept { release(memory); }
+void operator delete(void* memory, std::size_t) noexcept { release(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { release(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+
+#if CONVOLUTION_REALTIME_CHECK_MUTEX
+// Interposes the libc symbol: std::mutex, juce::CriticalSection and juce::WaitableEvent all lock
+// through it. The real function is looked up on first use; dlsym takes the loader's own lock,
+// not this one.
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    using LockFunction = int (*)(pthread_mutex_t*);
+    static std::atomic<LockFunction> realLock{ nullptr };
+
+    auto lock = realLock.load(std::memory_order_acquire);
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        realLock.store(lock, std::memory_order_release);
+    }
+
+    record(RealtimeCheck::Violation::mutexLock, 0);
+    return lock(mutex);
+}
+#endif
+
+namespace RealtimeCheck
+{
+    ScopedRealtimeSection::ScopedRealtimeSection() noexcept { ++realtimeDepth; }
+    ScopedRealtimeSection::~ScopedRealtimeSection() { --realtimeDepth; }
+
+    bool isEnabled() noexcept { return true; }
+
+    int getNumViolations() noexcept { return numViolations.load(std::memory_order_relaxed); }
+
+    void reset() noexcept { numViolations.store(0, std::memory_order_relaxed); }
+
+    void report()
+    {
+        const int total = getNumViolations();
+        for (int i = 0; i < std::min(total, maxRecords); ++i)
+        {
+            const auto& entry = records[i];
+            if (entry.violation == Violation::allocation)
+                std::fprintf(stderr, "real-time violation %d: %s of %zu bytes\n", i + 1, getName(entry.violation), entry.size);
+            else
+                std::fprintf(stderr, "real-time violation %d: %s\n", i + 1, getName(entry.violation));
+
+#if CONVOLUTION_REALTIME_CHECK_STACKS
+            if (char** symbols = backtrace_symbols(entry.frames, entry.numFrames))
+            {
+                for (int f = 0; f < entry.numFrames; ++f)
+                    std::fprintf(stderr, "    %s\n", symbols[f]);
+                std::free(symbols);
+            }
+#endif
+        }
+
+        if (total > maxRecords)
+            std::fprintf(stderr, "... and %d more without stacks\n", total - maxRecords);
+    }
+}
+
+#else
+
+namespace RealtimeCheck
+{
+    bool isEnabled() noexcept { return false; }
+    int getNumViolations() noexcept { return 0; }
+    void reset() noexcept {}
+
+    void report()
+    {
+        std::fprintf(stderr, "real-time checks are not compiled in (CONVOLUTION_REALTIME_CHECK)\n");
+    }
+}
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+// Debug aid that catches heap allocations, frees and mutex locks on real-time threads. Code that
+// must not block (processBlock, the tail workers' jobs) opens a ScopedRealtimeSection; with
+// CONVOLUTION_REALTIME_CHECK=1 (CMake option of the same name) global operator new/delete and, on
+// Linux, pthread_mutex_lock are replaced for the whole process, and every call made inside a
+// section is recorded with its call stack. Recording itself never allocates or locks, so it is
+// safe on the audio thread; report() symbolises the stacks later. Without the option the section
+// is an empty object and nothing is hooked.
+namespace RealtimeCheck
+{
+    enum class Violation
+    {
+        allocation,
+        deallocation,
+        mutexLock
+    };
+
+#if CONVOLUTION_REALTIME_CHECK
+    // Marks the calling thread as real-time for the lifetime of the object. Sections nest.
+    class ScopedRealtimeSection
+    {
+    public:
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection();
+
+        ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+        ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+    };
+#else
+    class ScopedRealtimeSection
+    {
+    public:
+        ScopedRealtimeSection() noexcept {}
+    };
+#endif
+
+    // True when the hooks are compiled in.
+    bool isEnabled() noexcept;
+
+    // Violations since start-up or the last reset(); only the first few keep their call stacks.
+    int getNumViolations() noexcept;
+    void reset() noexcept;
+
+    // Prints the recorded violations and their call stacks to stderr. Allocates; call it from a
+    // thread that is not real-time.
+    void report();
+}
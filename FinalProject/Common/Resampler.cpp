@@ -0,0 +1,278 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+ #define CONVOLUTION_RESAMPLER_X86 1
+ #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+ #define CONVOLUTION_RESAMPLER_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+ #define CONVOLUTION_RESAMPLER_TARGET(isa) __attribute__((target(isa)))
+#else
+ #define CONVOLUTION_RESAMPLER_TARGET(isa)
+#endif
+
+namespace
+{
+    // Sinc zero crossings on each side of the centre, at the cutoff frequency. With the Kaiser
+    // window below this puts the transition band (about 0.05 of the lower rate) just under its
+    // Nyquist frequency: flat to about 20 kHz for 44.1 kHz, with the stopband starting at 22.05 kHz.
+    constexpr int zeroCrossings = 64;
+    constexpr double cutoffFraction = 0.95; // of the lower Nyquist frequency
+    constexpr double kaiserBeta = 10.0;     // about -100 dB stopband
+    constexpr int tapMultiple = 16;
+
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 64 && term > sum * 1.0e-17; ++k)
+        {
+            const double half = x / (2.0 * k);
+            term *= half * half;
+            sum += term;
+        }
+        return sum;
+    }
+
+    void resampleScalar(float* out, const float* const* source, const float* const* taps, int numTaps, int numOutputs) noexcept
+    {
+        for (int n = 0; n < numOutputs; ++n)
+        {
+            float acc = 0.0f;
+            for (int k = 0; k < numTaps; ++k)
+                acc += taps[n][k] * source[n][k];
+            out[n] = acc;
+        }
+    }
+
+#if CONVOLUTION_RESAMPLER_X86
+    CONVOLUTION_RESAMPLER_TARGET("sse2")
+    void resampleSse2(float* out, const float* const* source, const float* const* taps, int numTaps, int numOutputs) noexcept
+    {
+        for (int n = 0; n < numOutputs; ++n)
+        {
+            __m128 acc0 = _mm_setzero_ps();
+            __m128 acc1 = _mm_setzero_ps();
+            for (int k = 0; k < numTaps; k += 8)
+            {
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(taps[n] + k), _mm_loadu_ps(source[n] + k)));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(taps[n] + k + 4), _mm_loadu_ps(source[n] + k + 4)));
+            }
+
+            __m128 sum = _mm_add_ps(acc0, acc1);
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+            out[n] = _mm_cvtss_f32(sum);
+        }
+    }
+
+    CONVOLUTION_RESAMPLER_TARGET("avx2,fma")
+    void resampleAvx2(float* out, const float* const* source, const float* const* taps, int numTaps, int numOutputs) noexcept
+    {
+        for (int n = 0; n < numOutputs; ++n)
+        {
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            for (int k = 0; k < numTaps; k += 16)
+            {
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(taps[n] + k), _mm256_loadu_ps(source[n] + k), acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(taps[n] + k + 8), _mm256_loadu_ps(source[n] + k + 8), acc1);
+            }
+
+            const __m256 sum8 = _mm256_add_ps(acc0, acc1);
+            __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+            sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+            sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+            out[n] = _mm_cvtss_f32(sum);
+        }
+    }
+
+    CONVOLUTION_RESAMPLER_TARGET("avx512f")
+    void resampleAvx512(float* out, const float* const* source, const float* const* taps, int numTaps, int numOutputs) noexcept
+    {
+        for (int n = 0; n < numOutputs; ++n)
+        {
+            __m512 acc = _mm512_setzero_ps();
+            for (int k = 0; k < numTaps; k += 16)
+                acc = _mm512_fmadd_ps(_mm512_loadu_ps(taps[n] + k), _mm512_loadu_ps(source[n] + k), acc);
+            out[n] = _mm512_reduce_add_ps(acc);
+        }
+    }
+#endif
+
+#if CONVOLUTION_RESAMPLER_NEON
+    void resampleNeon(float* out, const float* const* source, const float* const* taps, int numTaps, int numOutputs) noexcept
+    {
+        for (int n = 0; n < numOutputs; ++n)
+        {
+            float32x4_t acc0 = vdupq_n_f32(0.0f);
+            float32x4_t acc1 = vdupq_n_f32(0.0f);
+            for (int k = 0; k < numTaps; k += 8)
+            {
+                acc0 = vfmaq_f32(acc0, vld1q_f32(taps[n] + k), vld1q_f32(source[n] + k));
+                acc1 = vfmaq_f32(acc1, vld1q_f32(taps[n] + k + 4), vld1q_f32(source[n] + k + 4));
+            }
+            out[n] = vaddvq_f32(vaddq_f32(acc0, acc1));
+        }
+    }
+#endif
+}
+
+Resampler::Resampler(double sourceRate, double targetRate)
+{
+    const auto source = std::max<std::int64_t>(1, std::llround(sourceRate));
+    const auto target = std::max<std::int64_t>(1, std::llround(targetRate));
+    const auto divisor = std::gcd(source, target);
+    upFactor = static_cast<int>(target / divisor);
+    downFactor = static_cast<int>(source / divisor);
+    numPhases = std::min(upFactor, maxPhases);
+
+    // Lengths below are in source samples; downsampling widens the kernel by the rate ratio.
+    const double ratio = static_cast<double>(upFactor) / downFactor;
+    const double cutoff = 0.5 * std::min(1.0, ratio) * cutoffFraction; // cycles per source sample
+    const double halfLength = zeroCrossings / (2.0 * cutoff);
+    halfTaps = static_cast<int>(std::ceil(halfLength));
+    numTaps = (2 * halfTaps + tapMultiple - 1) / tapMultiple * tapMultiple;
+    const int numRows = numPhases + (numPhases < upFactor ? 1 : 0);
+    taps.assign(static_cast<size_t>(numRows) * static_cast<size_t>(numTaps), 0.0f);
+
+    const double pi = 3.14159265358979323846;
+    const double windowNorm = 1.0 / besselI0(kaiserBeta);
+    const double gain = static_cast<double>(downFactor) / upFactor;
+
+    // Row p is the kernel for an output p / numPhases of a sample right of source sample
+    // halfTaps - 1, so tap k sits at distance p / numPhases + halfTaps - 1 - k from it. Each
+    // row is normalised to unity DC gain so the phases do not ripple against each other.
+    // Interpolated banks get one more row, at a whole sample, for outputs past the last phase.
+    std::vector<double> row(static_cast<size_t>(2 * halfTaps));
+    for (int p = 0; p < numRows; ++p)
+    {
+        const double fraction = static_cast<double>(p) / numPhases;
+        double sum = 0.0;
+        for (int k = 0; k < 2 * halfTaps; ++k)
+        {
+            const double x = fraction + halfTaps - 1 - k;
+            const double u = x / halfLength;
+            double value = 0.0;
+            if (std::abs(u) < 1.0)
+            {
+                const double arg = 2.0 * cutoff * x;
+                const double sinc = arg == 0.0 ? 1.0 : std::sin(pi * arg) / (pi * arg);
+                value = 2.0 * cutoff * sinc * besselI0(kaiserBeta * std::sqrt(1.0 - u * u)) * windowNorm;
+            }
+            row[static_cast<size_t>(k)] = value;
+            sum += value;
+        }
+
+        float* dest = taps.data() + static_cast<size_t>(p) * static_cast<size_t>(numTaps);
+        for (int k = 0; k < 2 * halfTaps; ++k)
+            dest[k] = static_cast<float>(row[static_cast<size_t>(k)] * gain / sum);
+    }
+
+    kernel = getKernel();
+}
+
+std::int64_t Resampler::getOutputLength(std::int64_t numSourceSamples) const noexcept
+{
+    return (numSourceSamples * upFactor + downFactor - 1) / downFactor;
+}
+
+void Resampler::locate(std::int64_t output, std::int64_t& firstSource, int& phase, float& weight) const noexcept
+{
+    const std::int64_t position = output * downFactor;
+    const std::int64_t scaled = position % upFactor * numPhases;
+    phase = static_cast<int>(scaled / upFactor);
+    weight = static_cast<float>(scaled % upFactor) / static_cast<float>(upFactor);
+    firstSource = position / upFactor - halfTaps + 1;
+}
+
+Resampler::SourceRange Resampler::getSourceRange(std::int64_t firstOutput, int numOutputs) const noexcept
+{
+    SourceRange range;
+    if (numOutputs <= 0)
+        return range;
+
+    std::int64_t last = 0;
+    int phase = 0;
+    float weight = 0.0f;
+    locate(firstOutput, range.first, phase, weight);
+    locate(firstOutput + numOutputs - 1, last, phase, weight);
+    range.length = static_cast<int>(last + numTaps - range.first);
+    return range;
+}
+
+void Resampler::process(const float* source, float* output, std::int64_t firstOutput, int numOutputs) const
+{
+    std::int64_t first = 0;
+    int phase = 0;
+    float weight = 0.0f;
+    locate(firstOutput, first, phase, weight);
+    const std::int64_t origin = first;
+
+    const auto getRow = [this](int p) { return taps.data() + static_cast<size_t>(p) * static_cast<size_t>(numTaps); };
+
+    if (numPhases < upFactor)
+    {
+        // Between two rows of the bank: blend them, then run the kernel on the blend.
+        std::vector<float> blend(static_cast<size_t>(numTaps));
+        for (int n = 0; n < numOutputs; ++n)
+        {
+            locate(firstOutput + n, first, phase, weight);
+            const float* lower = getRow(phase);
+            const float* upper = getRow(phase + 1);
+            for (int k = 0; k < numTaps; ++k)
+                blend[static_cast<size_t>(k)] = lower[k] + weight * (upper[k] - lower[k]);
+
+            const float* sources[] = { source + (first - origin) };
+            const float* rows[] = { blend.data() };
+            kernel(output + n, sources, rows, numTaps, 1);
+        }
+        return;
+    }
+
+    constexpr int chunk = 64;
+    const float* sources[chunk];
+    const float* rows[chunk];
+    for (int done = 0; done < numOutputs; done += chunk)
+    {
+        const int count = std::min(chunk, numOutputs - done);
+        for (int n = 0; n < count; ++n)
+        {
+            locate(firstOutput + done + n, first, phase, weight);
+            sources[n] = source + (first - origin);
+            rows[n] = getRow(phase);
+        }
+        kernel(output + done, sources, rows, numTaps, count);
+    }
+}
+
+Resampler::Kernel Resampler::getKernel()
+{
+    static const Kernel active = getKernel(ComplexMac::getActiveIsa());
+    return active;
+}
+
+Resampler::Kernel Resampler::getKernel(ComplexMac::Isa isa)
+{
+    if (!ComplexMac::isSupported(isa))
+        return nullptr;
+
+    switch (isa)
+    {
+       #if CONVOLUTION_RESAMPLER_X86
+        case ComplexMac::Isa::sse2:   return resampleSse2;
+        case ComplexMac::Isa::avx2:   return resampleAvx2;
+        case ComplexMac::Isa::avx512: return resampleAvx512;
+       #endif
+       #if CONVOLUTION_RESAMPLER_NEON
+        case ComplexMac::Isa::neon:   return resampleNeon;
+       #endif
+        default:                      return resampleScalar;
+    }
+}
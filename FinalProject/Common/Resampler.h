@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ComplexMac.h"
+
+// Polyphase windowed-sinc sample-rate converter, used by IRLoader to bring IRs to the session
+// rate. The rate ratio is reduced to upFactor / downFactor, so output sample j lies at source
+// position j * downFactor / upFactor. Each fractional phase has its own row of taps, a Kaiser
+// windowed sinc (about -100 dB stopband) cut off just below the lower of the two Nyquist
+// frequencies. Ratios that would need more than maxPhases rows (rates with no large common
+// divisor) interpolate linearly between the two nearest of maxPhases evenly spaced rows.
+//
+// Output is scaled by sourceRate / targetRate, which keeps an IR's frequency response (and so the
+// reverb's level) the same at any rate. process() only reads the filter bank, so any number of
+// threads can run it at once on different output ranges.
+class Resampler
+{
+public:
+    static constexpr int maxPhases = 1024;
+
+    // Rates are rounded to whole Hz before the ratio is reduced.
+    Resampler(double sourceRate, double targetRate);
+
+    int getUpFactor() const noexcept { return upFactor; }
+    int getDownFactor() const noexcept { return downFactor; }
+    int getNumTaps() const noexcept { return numTaps; }
+
+    // Output samples covering numSourceSamples source samples.
+    std::int64_t getOutputLength(std::int64_t numSourceSamples) const noexcept;
+
+    // The source samples [first, first + length) that outputs [firstOutput, firstOutput + numOutputs)
+    // read. `first` may be negative and the range may run past the signal; those samples are zero.
+    struct SourceRange
+    {
+        std::int64_t first = 0;
+        int length = 0;
+    };
+    SourceRange getSourceRange(std::int64_t firstOutput, int numOutputs) const noexcept;
+
+    // Writes outputs [firstOutput, firstOutput + numOutputs) from `source`, which holds the samples
+    // of getSourceRange(firstOutput, numOutputs).
+    void process(const float* source, float* output, std::int64_t firstOutput, int numOutputs) const;
+
+    // out[n] = sum_k taps[n][k] * source[n][k] for k in [0, numTaps), numTaps a multiple of 16.
+    // Kernels vectorise across taps with one horizontal sum per output; variants follow the same
+    // runtime selection as ComplexMac.
+    using Kernel = void (*)(float* out, const float* const* source, const float* const* taps,
+                            int numTaps, int numOutputs) noexcept;
+
+    static Kernel getKernel();
+    static Kernel getKernel(ComplexMac::Isa isa);
+
+private:
+    int upFactor = 1;
+    int downFactor = 1;
+    int numPhases = 1;
+    int halfTaps = 0;           // taps before and including the one at or left of the output position
+    int numTaps = 0;            // per row, padded to a multiple of 16
+    std::vector<float> taps;    // numPhases rows of numTaps, plus one when interpolating
+    Kernel kernel = nullptr;
+
+    // First source sample read by an output, the row it uses and how far it is towards the next
+    // row (always 0 unless the bank is interpolated).
+    void locate(std::int64_t output, std::int64_t& firstSource, int& phase, float& weight) const noexcept;
+};
@@ -0,0 +1,59 @@
+#include "Semaphore.h"
+
+#if defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+ #include <climits>
+#elif defined(__APPLE__)
+ #include <dispatch/dispatch.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+#if defined(_WIN32)
+struct Semaphore::Native
+{
+    HANDLE handle = CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+    ~Native() { CloseHandle(handle); }
+};
+
+void Semaphore::signal() noexcept { ReleaseSemaphore(native->handle, 1, nullptr); }
+void Semaphore::wait() noexcept { WaitForSingleObject(native->handle, INFINITE); }
+
+#elif defined(__APPLE__)
+// Unnamed POSIX semaphores are not implemented on macOS.
+struct Semaphore::Native
+{
+    dispatch_semaphore_t handle = dispatch_semaphore_create(0);
+    ~Native() { dispatch_release(handle); }
+};
+
+void Semaphore::signal() noexcept { dispatch_semaphore_signal(native->handle); }
+void Semaphore::wait() noexcept { dispatch_semaphore_wait(native->handle, DISPATCH_TIME_FOREVER); }
+
+#else
+struct Semaphore::Native
+{
+    sem_t handle;
+    Native() { sem_init(&handle, 0, 0); }
+    ~Native() { sem_destroy(&handle); }
+};
+
+void Semaphore::signal() noexcept { sem_post(&native->handle); }
+
+void Semaphore::wait() noexcept
+{
+    while (sem_wait(&native->handle) != 0 && errno == EINTR)
+    {
+    }
+}
+#endif
+
+Semaphore::Semaphore() : native(std::make_unique<Native>()) {}
+Semaphore::~Semaphore() = default;
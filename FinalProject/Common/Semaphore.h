@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+
+// Counting semaphore for waking worker threads from the audio thread. signal() never takes a
+// lock: it is a futex-backed POSIX semaphore on Linux, a dispatch semaphore on Apple platforms and
+// a kernel semaphore on Windows, each of which only enters the kernel when a thread is waiting.
+// (juce::WaitableEvent::signal locks a mutex; std::counting_semaphore needs C++20.)
+class Semaphore
+{
+public:
+    Semaphore();
+    ~Semaphore();
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    void signal() noexcept;
+    // Blocks until a signal is available and consumes it.
+    void wait() noexcept;
+
+private:
+    struct Native;
+    std::unique_ptr<Native> native;
+};
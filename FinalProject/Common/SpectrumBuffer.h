@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+// Contiguous, 64-byte aligned storage for a run of half spectra (fftSize / 2 + 1 bins each).
+// Every spectrum is stored as split planes, [real 0..stride)[imag 0..stride), with the stride
+// padded to a whole number of cache lines so each plane starts aligned and the padding bins
+// stay zero (kernels may safely run over the full stride). `Sample` is float, or uint16_t for
+// IR spectra kept as fp16/bf16 (CompactSpectrumBuffer); a compact stride is never shorter than
+// the float stride for the same bin count. A buffer can also be attached to spectra in that
+// layout that live elsewhere (IR spectra memory-mapped from the disk cache); those are read-only.
+template <typename Sample>
+class BasicSpectrumBuffer
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    BasicSpectrumBuffer() = default;
+    BasicSpectrumBuffer(int numSpectra, int numBins) { allocate(numSpectra, numBins); }
+
+    void allocate(int numSpectra, int numBins)
+    {
+        count = std::max(0, numSpectra);
+        bins = std::max(0, numBins);
+        stride = getStrideFor(bins);
+
+        const size_t total = getTotalSamples();
+        data.reset(total > 0 ? static_cast<Sample*>(::operator new[](total * sizeof(Sample), std::align_val_t{ alignment }))
+                             : nullptr);
+        samples = data.get();
+        clear();
+    }
+
+    // Uses numSpectra spectra laid out as allocate() would lay them out, starting at `external`
+    // (64-byte aligned), without copying. The memory must outlive the buffer and is never written.
+    void attach(const Sample* external, int numSpectra, int numBins) noexcept
+    {
+        count = std::max(0, numSpectra);
+        bins = std::max(0, numBins);
+        stride = getStrideFor(bins);
+        data.reset();
+        samples = const_cast<Sample*>(external);
+    }
+
+    // Samples per plane for numBins bins, padded to whole cache lines.
+    static int getStrideFor(int numBins) noexcept { return (numBins + samplesPerLine - 1) / samplesPerLine * samplesPerLine; }
+
+    void clear() noexcept
+    {
+        if (data)
+            std::fill(data.get(), data.get() + getTotalSamples(), Sample{});
+    }
+
+    void clearSpectrum(int index) noexcept
+    {
+        std::fill(real(index), real(index) + stride * 2, Sample{});
+    }
+
+    int getNumSpectra() const noexcept { return count; }
+    int getNumBins() const noexcept { return bins; }
+    int getStride() const noexcept { return stride; }
+    size_t getTotalSamples() const noexcept { return static_cast<size_t>(count) * static_cast<size_t>(stride) * 2; }
+    size_t getSizeInBytes() const noexcept { return getTotalSamples() * sizeof(Sample); }
+
+    Sample* real(int index) noexcept { return samples + static_cast<size_t>(index) * static_cast<size_t>(stride) * 2; }
+    Sample* imag(int index) noexcept { return real(index) + stride; }
+    const Sample* real(int index) const noexcept { return samples + static_cast<size_t>(index) * static_cast<size_t>(stride) * 2; }
+    const Sample* imag(int index) const noexcept { return real(index) + stride; }
+
+private:
+    struct AlignedDelete
+    {
+        void operator()(Sample* p) const noexcept { ::operator delete[](p, std::align_val_t{ alignment }); }
+    };
+
+    static constexpr int samplesPerLine = static_cast<int>(alignment / sizeof(Sample));
+
+    std::unique_ptr<Sample[], AlignedDelete> data; // null for attached buffers
+    Sample* samples = nullptr;
+    int count = 0;
+    int bins = 0;
+    int stride = 0;
+};
+
+using SpectrumBuffer = BasicSpectrumBuffer<float>;
+using CompactSpectrumBuffer = BasicSpectrumBuffer<uint16_t>;
@@ -1,277 +0,0 @@
-#include "ConvolutionEngine.h"
-#include <cmath>
-
-ConvolutionEngine::ConvolutionEngine() = default;
-
-void ConvolutionEngine::prepare(double newSampleRate, int newBlockSize, int numChannels)
-{
-    sampleRate = newSampleRate;
-    blockSize = newBlockSize;
-    ensureFFTOrder(11); // default start, may be changed by IR
-    resizeBuffers(numChannels, numPartitions);
-    reset();
-}
-
-void ConvolutionEngine::reset()
-{
-    for (auto& ch : overlapBuffers)
-        std::fill(ch.begin(), ch.end(), 0.0f);
-}
-
-void ConvolutionEngine::setIR(const std::shared_ptr<IRData>& ir)
-{
-    if (!ir)
-        return;
-
-    partitionSize = ir->partitionSize;
-    numPartitions = ir->numPartitions;
-    ensureFFTOrder(ir->fftOrder);
-    std::atomic_store_explicit(&currentIR, ir, std::memory_order_release);
-    resizeBuffers(ir->numChannels, ir->numPartitions);
-    reset();
-}
-
-void ConvolutionEngine::setMix(float wetDry)
-{
-    wetMix = std::clamp(wetDry, 0.0f, 1.0f);
-}
-
-void ConvolutionEngine::setOutputTrim(float db)
-{
-    outputGain = juce::Decibels::decibelsToGain(db);
-}
-
-void ConvolutionEngine::process(juce::AudioBuffer<float>& buffer)
-{
-    juce::ScopedNoDenormals guard;
-
-    const int numChannels = buffer.getNumChannels();
-    const int numSamples = buffer.getNumSamples();
-
-    dryCopy.resize(static_cast<size_t>(numSamples));
-
-    resizeBuffers(numChannels, numPartitions);
-
-    for (int ch = 0; ch < numChannels; ++ch)
-        processBlockPartitioned(ch, buffer.getWritePointer(ch), numSamples);
-}
-
-void ConvolutionEngine::ensureFFTOrder(int desiredOrder)
-{
-    if (desiredOrder == fftOrder && !tempFreq.empty())
-        return;
-
-    fftOrder = desiredOrder;
-    fftSize = 1 << fftOrder;
-    tempFreq.assign(static_cast<size_t>(fftSize * 2), 0.0f);
-    accumFreq.assign(static_cast<size_t>(fftSize * 2), 0.0f);
-    ifftTime.assign(static_cast<size_t>(fftSize), 0.0f);
-    complexBuffer.assign(static_cast<size_t>(fftSize), std::complex<float>(0.0f, 0.0f));
-
-    for (auto& ch : overlapBuffers)
-        ch.resize(static_cast<size_t>(fftSize), 0.0f);
-}
-
-void ConvolutionEngine::resizeBuffers(int numChannels, int partitions)
-{
-    if (numChannels <= 0)
-        return;
-
-    overlapBuffers.resize(static_cast<size_t>(numChannels));
-    for (auto& ch : overlapBuffers)
-        ch.resize(static_cast<size_t>(fftSize), 0.0f);
-
-    inputSpectra.resize(static_cast<size_t>(numChannels));
-    writePositions.assign(static_cast<size_t>(numChannels), 0);
-    for (auto& channelBuffer : inputSpectra)
-    {
-        channelBuffer.resize(static_cast<size_t>(std::max(1, partitions)));
-        for (auto& spectrum : channelBuffer)
-            spectrum.assign(static_cast<size_t>(fftSize * 2), 0.0f);
-    }
-}
-
-void ConvolutionEngine::processBlockPartitioned(int channel, float* samples, int numSamples)
-{
-    auto ir = std::atomic_load_explicit(&currentIR, std::memory_order_acquire);
-    if (!ir || ir->partitions.empty())
-        return;
-
-    // Keep a copy of the dry input to avoid overwriting while mixing.
-    std::copy(samples, samples + numSamples, dryCopy.begin());
-
-    int processed = 0;
-    while (processed < numSamples)
-    {
-        const int chunkSize = std::min(partitionSize, numSamples - processed);
-        processChunk(channel, samples, processed, chunkSize);
-        processed += chunkSize;
-    }
-}
-
-void ConvolutionEngine::processChunk(int channel, float* samples, int chunkOffset, int chunkSize)
-{
-    auto ir = std::atomic_load_explicit(&currentIR, std::memory_order_acquire);
-    if (!ir || ir->partitions.empty())
-        return;
-
-    const int channelIndex = std::min(channel, ir->numChannels - 1);
-    const int bins = fftSize / 2 + 1;
-
-    // Prepare input FFT buffer using internal FFT
-    performFFT(samples + chunkOffset, chunkSize, tempFreq);
-
-    auto& channelSpectra = inputSpectra[static_cast<size_t>(channel)];
-    auto& writePos = writePositions[static_cast<size_t>(channel)];
-    channelSpectra[static_cast<size_t>(writePos)] = tempFreq; // store current block spectrum
-
-    // Accumulate frequency response
-    std::fill(accumFreq.begin(), accumFreq.end(), 0.0f);
-    for (int p = 0; p < ir->numPartitions; ++p)
-    {
-        const int idx = (writePos - p);
-        const int inputIndex = (idx < 0 ? idx + ir->numPartitions : idx);
-        const auto& X = channelSpectra[static_cast<size_t>(inputIndex)];
-        const auto& H = ir->partitions[channelIndex][static_cast<size_t>(p)];
-
-        for (int k = 0; k < bins; ++k)
-        {
-            const int bi = k * 2;
-            const float xr = X[bi];
-            const float xi = X[bi + 1];
-            const float hr = H[bi];
-            const float hi = H[bi + 1];
-
-            accumFreq[bi]     += (xr * hr) - (xi * hi);
-            accumFreq[bi + 1] += (xr * hi) + (xi * hr);
-        }
-    }
-
-    // IFFT
-    performIFFT(accumFreq, ifftTime);
-    const float scale = 1.0f / static_cast<float>(fftSize);
-
-    auto& overlap = overlapBuffers[static_cast<size_t>(channel)];
-    const float dryMix = 1.0f - wetMix;
-
-    for (int n = 0; n < chunkSize; ++n)
-    {
-        const float wet = (ifftTime[n] * scale) + overlap[n];
-        samples[chunkOffset + n] = outputGain * (wetMix * wet + dryMix * dryCopy[chunkOffset + n]);
-    }
-
-    // Shift existing overlap forward by chunkSize samples
-    if (chunkSize < fftSize)
-    {
-        const int remain = fftSize - chunkSize;
-        std::move(overlap.begin() + chunkSize, overlap.end(), overlap.begin());
-        std::fill(overlap.begin() + remain, overlap.end(), 0.0f);
-
-        // Add new tail into overlap
-        const int tail = remain;
-        for (int i = 0; i < tail; ++i)
-            overlap[i] += ifftTime[chunkSize + i] * scale;
-    }
-
-    writePos = (writePos + 1) % std::max(1, ir->numPartitions);
-}
-
-void ConvolutionEngine::performFFT(const float* timeDomain, int numSamples, std::vector<float>& freqOut)
-{
-    const int copyCount = std::min(numSamples, fftSize);
-
-    if (complexBuffer.size() != static_cast<size_t>(fftSize))
-        complexBuffer.assign(static_cast<size_t>(fftSize), std::complex<float>(0.0f, 0.0f));
-
-    for (int i = 0; i < copyCount; ++i)
-        complexBuffer[static_cast<size_t>(i)] = std::complex<float>(timeDomain[i], 0.0f);
-
-    for (int i = copyCount; i < fftSize; ++i)
-        complexBuffer[static_cast<size_t>(i)] = std::complex<float>(0.0f, 0.0f);
-
-    fftIterative(complexBuffer, false);
-
-    if (freqOut.size() != static_cast<size_t>(fftSize * 2))
-        freqOut.resize(static_cast<size_t>(fftSize * 2));
-    std::fill(freqOut.begin(), freqOut.end(), 0.0f);
-
-    const int bins = fftSize / 2 + 1;
-    for (int k = 0; k < bins; ++k)
-    {
-        const int bi = k * 2;
-        const auto& c = complexBuffer[static_cast<size_t>(k)];
-        freqOut[bi] = c.real();
-        freqOut[bi + 1] = c.imag();
-    }
-}
-
-void ConvolutionEngine::performIFFT(const std::vector<float>& freqIn, std::vector<float>& timeOut)
-{
-    if (complexBuffer.size() != static_cast<size_t>(fftSize))
-        complexBuffer.assign(static_cast<size_t>(fftSize), std::complex<float>(0.0f, 0.0f));
-
-    const int bins = fftSize / 2 + 1;
-    for (int k = 0; k < bins; ++k)
-    {
-        const int bi = k * 2;
-        complexBuffer[static_cast<size_t>(k)] = std::complex<float>(freqIn[bi], freqIn[bi + 1]);
-    }
-
-    for (int k = 1; k < fftSize / 2; ++k)
-        complexBuffer[static_cast<size_t>(fftSize - k)] = std::conj(complexBuffer[static_cast<size_t>(k)]);
-
-    if (fftSize > 1)
-    {
-        const int nyquist = fftSize / 2;
-        complexBuffer[static_cast<size_t>(nyquist)] = std::complex<float>(
-            freqIn[static_cast<size_t>(nyquist * 2)],
-            freqIn[static_cast<size_t>(nyquist * 2 + 1)]);
-    }
-
-    fftIterative(complexBuffer, true);
-
-    if (timeOut.size() != static_cast<size_t>(fftSize))
-        timeOut.resize(static_cast<size_t>(fftSize));
-
-    for (int n = 0; n < fftSize; ++n)
-        timeOut[static_cast<size_t>(n)] = complexBuffer[static_cast<size_t>(n)].real();
-}
-
-void ConvolutionEngine::fftIterative(std::vector<std::complex<float>>& buffer, bool inverse)
-{
-    const size_t n = buffer.size();
-    if (n <= 1)
-        return;
-
-    for (size_t i = 1, j = 0; i < n; ++i)
-    {
-        size_t bit = n >> 1;
-        for (; j & bit; bit >>= 1)
-            j ^= bit;
-        j ^= bit;
-        if (i < j)
-            std::swap(buffer[i], buffer[j]);
-    }
-
-    const float dir = inverse ? 1.0f : -1.0f;
-
-    for (size_t len = 2; len <= n; len <<= 1)
-    {
-        const float angle = dir * juce::MathConstants<float>::twoPi / static_cast<float>(len);
-        const std::complex<float> wLen(std::cos(angle), std::sin(angle));
-
-        for (size_t i = 0; i < n; i += len)
-        {
-            std::complex<float> w(1.0f, 0.0f);
-            const size_t half = len >> 1;
-            for (size_t j = 0; j < half; ++j)
-            {
-                const auto u = buffer[i + j];
-                const auto v = buffer[i + j + half] * w;
-                buffer[i + j] = u + v;
-                buffer[i + j + half] = u - v;
-                w *= wLen;
-            }
-        }
-    }
-}
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeCheck.h"
 
 //==============================================================================
 Convolution_ReverbAudioProcessor::Convolution_ReverbAudioProcessor()
@@ -9,9 +10,21 @@ Convolution_ReverbAudioProcessor::Convolution_ReverbAudioProcessor()
       parameters(*this, nullptr, "PARAMETERS", createParameterLayout())
 {
     engine = std::make_unique<ConvolutionEngine>();
+    // The head of a new IR is audible as soon as it is transformed; the tail follows as it loads.
+    irLoader.setProgressiveLoading(true);
+
+    // IR swaps retire the previous engine state on the audio thread; it is freed here instead.
+    startTimerHz(4);
 }
 
-Convolution_ReverbAudioProcessor::~Convolution_ReverbAudioProcessor() = default;
+Convolution_ReverbAudioProcessor::~Convolution_ReverbAudioProcessor()
+{
+    stopTimer();
+
+    // A load still in flight writes this processor's members; let it finish first.
+    if (loaderFuture.valid())
+        loaderFuture.wait();
+}
 
 //==============================================================================
 const juce::String Convolution_ReverbAudioProcessor::getName() const
@@ -41,6 +54,13 @@ void Convolution_ReverbAudioProcessor::prepareToPlay(double sampleRate, int samp
     lastBlockSize.store(samplesPerBlock);
 
     engine->prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+    setLatencySamples(engine->getLatencySamples());
+
+    // IRs are resampled to the session rate as they load. The reload runs from timerCallback,
+    // so prepare never waits on a load. The spectra cache keeps a copy per rate, so switching
+    // back to a rate used before maps it instead of resampling again.
+    if (sampleRate != loadedIRSampleRate.load())
+        rateReloadPending.store(true);
 
     dryWetSmoothed.reset(sampleRate, 0.02);
     trimSmoothed.reset(sampleRate, 0.02);
@@ -58,6 +78,8 @@ void Convolution_ReverbAudioProcessor::releaseResources()
 void Convolution_ReverbAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
 {
     juce::ScopedNoDenormals guard;
+    const RealtimeCheck::ScopedRealtimeSection realtimeSection;
+    const CpuMeter::ScopedBlock cpuTime(engine->getCpuMeter(), buffer.getNumSamples());
 
     const int totalNumInputChannels = getTotalNumInputChannels();
     const int totalNumOutputChannels = getTotalNumOutputChannels();
@@ -72,6 +94,32 @@ void Convolution_ReverbAudioProcessor::processBlock(juce::AudioBuffer<float>& bu
     engine->process(buffer);
 }
 
+void Convolution_ReverbAudioProcessor::timerCallback()
+{
+    engine->releaseRetiredStates();
+
+    // Hosts expect latency changes on the message thread, so a load's new latency is published
+    // from here rather than from the loader thread.
+    if (getLatencySamples() != engine->getLatencySamples())
+        setLatencySamples(engine->getLatencySamples());
+
+    // A load already running may have picked up the old rate, so wait for it before checking.
+    if (rateReloadPending.load() && !isLoading.load())
+    {
+        rateReloadPending.store(false);
+        if (currentIRFile != juce::File() && lastSampleRate.load() != loadedIRSampleRate.load())
+            loadImpulse(currentIRFile);
+    }
+
+    // Builds with CONVOLUTION_REALTIME_CHECK: surface anything processBlock did that could block.
+    if (RealtimeCheck::getNumViolations() > 0)
+    {
+        RealtimeCheck::report();
+        RealtimeCheck::reset();
+        jassertfalse;
+    }
+}
+
 //==============================================================================
 bool Convolution_ReverbAudioProcessor::hasEditor() const
 {
@@ -135,12 +183,16 @@ void Convolution_ReverbAudioProcessor::loadImpulse(const juce::File& file)
 
     isLoading.store(true);
     currentIRName = "Loading...";
+    currentIRFile = file;
 
     loaderFuture = std::async(std::launch::async, [this, file]() {
-        auto ir = irLoader.loadIR(file, lastSampleRate.load(), lastBlockSize.load());
+        const double sampleRate = lastSampleRate.load();
+        auto ir = irLoader.loadIR(file, sampleRate, lastBlockSize.load());
         if (ir)
         {
-            engine->setIR(ir);
+            loadedIRSampleRate.store(sampleRate);
+            engine->setIR(ir); // timerCallback reports the new state's latency to the host
+            tailLengthSeconds.store(ir->irLength / sampleRate);
             currentIRName = file.getFileName();
         }
         else
@@ -6,7 +6,8 @@
 #include "ConvolutionEngine.h"
 #include "IRLoader.h"
 
-class Convolution_ReverbAudioProcessor : public juce::AudioProcessor
+class Convolution_ReverbAudioProcessor : public juce::AudioProcessor,
+                                         private juce::Timer
 {
 public:
     Convolution_ReverbAudioProcessor();
@@ -27,7 +28,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override { return tailLengthSeconds.load(); }
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -43,20 +44,38 @@ public:
     void loadImpulse(const juce::File& file);
     juce::String getCurrentIRName() const { return currentIRName; }
     bool isLoadingIR() const { return isLoading.load(); }
+    // Audio-thread load of recent processBlock calls, per engine stage; read from the message thread.
+    const CpuMeter& getCpuMeter() const { return engine->getCpuMeter(); }
+    int getTailDeadlineMisses() const { return engine->getTailDeadlineMisses(); }
+
+    // Rebuilds the engine state for the current IR with another FFT implementation.
+    void setFftBackend(FftBackend::Kind kind) { engine->setFftBackend(kind); }
 
     juce::AudioProcessorValueTreeState& getState() { return parameters; }
 
 private:
+    void timerCallback() override;
+
     juce::AudioProcessorValueTreeState parameters;
     std::unique_ptr<ConvolutionEngine> engine;
     IRLoader irLoader;
 
-    std::future<void> loaderFuture;
     std::atomic<bool> isLoading{ false };
     juce::String currentIRName{ "None" };
 
+    // The IR file in use (message thread only) and the session rate it was resampled to. When
+    // prepareToPlay sees a new rate it sets rateReloadPending, and timerCallback reloads the IR.
+    juce::File currentIRFile;
+    std::atomic<double> loadedIRSampleRate{ 0.0 };
+    std::atomic<bool> rateReloadPending{ false };
+
     std::atomic<double> lastSampleRate{ 44100.0 };
     std::atomic<int> lastBlockSize{ 512 };
+    std::atomic<double> tailLengthSeconds{ 0.0 }; // length of the loaded IR
+
+    // Declared after everything the load writes, so its join on destruction runs before any of
+    // that goes.
+    std::future<void> loaderFuture;
 
     juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> dryWetSmoothed;
     juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> trimSmoothed;
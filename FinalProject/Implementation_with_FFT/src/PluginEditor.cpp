@@ -4,7 +4,7 @@
 Convolution_ReverbAudioProcessorEditor::Convolution_ReverbAudioProcessorEditor(Convolution_ReverbAudioProcessor& p)
     : AudioProcessorEditor(&p), processor(p)
 {
-    setSize(420, 240);
+    setSize(420, 310);
 
     loadButton.onClick = [this]()
     {
@@ -24,6 +24,11 @@ Convolution_ReverbAudioProcessorEditor::Convolution_ReverbAudioProcessorEditor(C
     statusLabel.setJustificationType(juce::Justification::centredLeft);
     addAndMakeVisible(statusLabel);
 
+    cpuLabel.setFont(juce::Font(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain)));
+    cpuLabel.setJustificationType(juce::Justification::centredLeft);
+    cpuLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    addAndMakeVisible(cpuLabel);
+
     dryWetSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
     dryWetSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 20);
     dryWetSlider.setName("Dry/Wet");
@@ -72,6 +77,8 @@ void Convolution_ReverbAudioProcessorEditor::resized()
     loadButton.setBounds(header.removeFromRight(120));
     statusLabel.setBounds(header);
 
+    cpuLabel.setBounds(area.removeFromBottom(60));
+
     auto knobs = area.removeFromTop(160);
     auto knobWidth = knobs.getWidth() / 2;
     dryWetSlider.setBounds(knobs.removeFromLeft(knobWidth).reduced(10));
@@ -84,4 +91,23 @@ void Convolution_ReverbAudioProcessorEditor::timerCallback()
     if (processor.isLoadingIR())
         status += " (loading...)";
     statusLabel.setText(status, juce::dontSendNotification);
+
+    // Share of each block's duration spent in processBlock over the last CpuMeter::historyLength
+    // blocks; overruns are blocks that took longer than their own duration.
+    const auto cpu = processor.getCpuMeter().getSnapshot();
+    const auto stageLine = [&cpu](const char* name, float CpuMeter::Stats::*value)
+    {
+        juce::String line(name);
+        for (int stage = 0; stage < CpuMeter::numStages; ++stage)
+            line += juce::String::formatted("  %s %4.1f", CpuMeter::getStageName(static_cast<CpuMeter::Stage>(stage)),
+                                            cpu.stages[static_cast<size_t>(stage)].*value);
+        return line + "\n";
+    };
+
+    cpuLabel.setText(juce::String::formatted("CPU  avg %4.1f%%  p99 %4.1f%%  max %4.1f%%\n", cpu.total.mean, cpu.total.p99, cpu.total.max)
+                         + stageLine("avg", &CpuMeter::Stats::mean)
+                         + stageLine("p99", &CpuMeter::Stats::p99)
+                         + juce::String::formatted("overruns %lld  tail deadline misses %d", static_cast<long long>(cpu.overruns),
+                                                   processor.getTailDeadlineMisses()),
+                     juce::dontSendNotification);
 }
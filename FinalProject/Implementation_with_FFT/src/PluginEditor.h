@@ -21,6 +21,7 @@ private:
     juce::TextButton loadButton{ "Load IR" };
     std::unique_ptr<juce::FileChooser> fileChooser;
     juce::Label statusLabel;
+    juce::Label cpuLabel;
 
     juce::Slider dryWetSlider;
     juce::Slider trimSlider;
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Synthetic IRs shared by the benchmarks, so their timings are taken on the same signals.
+namespace BenchmarkIRs
+{
+    // Exponentially decaying noise, -60 dB at the end of the IR, one independent channel per path.
+    inline juce::AudioBuffer<float> makeDecayingNoise(double seconds, double sampleRate, int numPaths)
+    {
+        const int length = std::max(1, static_cast<int>(seconds * sampleRate));
+        const double decayPerSample = std::log(1000.0) / length;
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+        juce::AudioBuffer<float> ir(numPaths, length);
+        for (int ch = 0; ch < numPaths; ++ch)
+            for (int n = 0; n < length; ++n)
+                ir.setSample(ch, n, noise(rng) * static_cast<float>(std::exp(-decayPerSample * n)));
+        return ir;
+    }
+}
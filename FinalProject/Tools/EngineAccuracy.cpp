@@ -0,0 +1,524 @@
+// Golden-reference accuracy check for ConvolutionEngine. Every scenario is rendered through the
+// engine under each configuration (block sizes including odd, varying and oversized host blocks,
+// FFT backends, tail scheduling, zero-latency heads, compact tail spectra, offline planning,
+// background tail workers) and
+// compared with a direct time-domain convolution in double precision. The error is the residual
+// energy relative to the reference's on the worst channel, in dB; each configuration has a budget.
+// Before that, every ComplexMac variant the CPU runs is held to the per-bin tolerance ComplexMac.h
+// documents against the scalar kernel.
+//
+//     EngineAccuracy [--filter text]     only scenarios or configurations whose name contains text
+//
+// Exits with status 1 if any run exceeds its budget. Background tail workers only give exact output
+// when they keep up, so configurations that use them feed the engine in real time. One scenario
+// holds the worker long enough to overflow its job ring and checks that the tail recovers.
+
+#include "ConvolutionEngine.h"
+#include "FftBackend.h"
+#include "IRLoader.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    // Budgets per spectrum format. fp32 paths measure around -140 dB; the compact formats are
+    // bounded by their mantissas (fp16 around -75 dB, bf16 around -57 dB on noise IRs).
+    constexpr double fp32BudgetDb = -100.0;
+    constexpr double fp16BudgetDb = -60.0;
+    constexpr double bf16BudgetDb = -45.0;
+
+    // ComplexMac's documented bound: each bin within this many FLT_EPSILON * sum(|x| * |h|) of scalar.
+    constexpr double macBudgetEpsilons = 4.0;
+
+    struct Scenario
+    {
+        const char* name;
+        int numChannels = 1;             // bus channels
+        juce::AudioBuffer<float> ir;     // 1, 2 or 4 (true stereo) paths
+        juce::AudioBuffer<float> input;  // numChannels channels
+
+        // Optional IR swap: the engine is given swapIR just before the block starting at swapAt,
+        // and crossfades to it over crossfadeSeconds.
+        juce::AudioBuffer<float> swapIR;
+        int swapAt = -1;
+        double crossfadeSeconds = 0.0;
+
+        // Optional overload: background tail workers are held for stallLength samples from stallAt.
+        // The scenario must then record deadline misses when run with background tails.
+        int stallAt = -1;
+        int stallLength = 0;
+    };
+
+    struct Config
+    {
+        const char* name;
+        int preparedBlockSize = 512;
+        int hostBlockSize = 512; // 0: random sizes from 1 to preparedBlockSize
+        FftBackend::Kind backend = FftBackend::Kind::simd;
+        ConvolutionEngine::TailScheduling scheduling = ConvolutionEngine::TailScheduling::distributed;
+        bool zeroLatency = false;
+        bool offline = false;
+        ComplexMac::SpectrumFormat format = ComplexMac::SpectrumFormat::fp32;
+        double budgetDb = fp32BudgetDb;
+        int backgroundPartitionSize = 0; // > 0: tiers with partitions this large run on a worker
+    };
+
+    using Signal = std::vector<std::vector<double>>; // per output channel
+
+    juce::AudioBuffer<float> makeNoise(int numChannels, int length, unsigned seed, double decaySeconds = 0.0)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        juce::AudioBuffer<float> buffer(numChannels, length);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int n = 0; n < length; ++n)
+            {
+                const double envelope = decaySeconds > 0.0 ? std::exp(-n / (decaySeconds * sampleRate)) : 1.0;
+                buffer.setSample(ch, n, noise(rng) * static_cast<float>(envelope));
+            }
+        return buffer;
+    }
+
+    juce::AudioBuffer<float> makeImpulses(int numChannels, int length, std::initializer_list<int> positions, float gain)
+    {
+        juce::AudioBuffer<float> buffer(numChannels, length);
+        buffer.clear();
+        int ch = 0;
+        for (int position : positions)
+            buffer.setSample(ch++ % numChannels, position, gain);
+        return buffer;
+    }
+
+    // Runs `numPartitions` calls of the fused kernel for `isa` over random spectra, as one tier's
+    // MAC does, and returns the worst bin's distance from the scalar kernel in units of
+    // FLT_EPSILON * sum(|x| * |h|). The bin count is odd so every vector width also runs its tail.
+    double checkMacKernel(ComplexMac::Isa isa, ComplexMac::SpectrumFormat format, int numLanes)
+    {
+        using Format = ComplexMac::SpectrumFormat;
+        constexpr int numBins = 1025;
+        constexpr int numPartitions = 50;
+        constexpr float hScale = 0.75f;
+        const auto bins = static_cast<size_t>(numBins);
+
+        std::mt19937 rng(static_cast<unsigned>(numLanes) * 31u + static_cast<unsigned>(format));
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+        const auto fill = [&](std::vector<float>& plane) {
+            for (auto& x : plane)
+                x = value(rng);
+        };
+
+        // Per lane: x planes, then the accumulators of the tested and the scalar kernel.
+        const auto lanes = static_cast<size_t>(numLanes);
+        std::vector<std::vector<float>> xRe(lanes, std::vector<float>(bins)), xIm = xRe;
+        std::vector<std::vector<float>> accRe(lanes, std::vector<float>(bins, 0.0f)), accIm = accRe;
+        auto expectedRe = accRe, expectedIm = accIm;
+        std::vector<double> magnitudeSum(lanes * bins, 0.0);
+        std::vector<float> hRe(bins), hIm(bins);
+        std::vector<uint16_t> compactRe(bins), compactIm(bins);
+        std::vector<ComplexMac::Lane> tested(lanes), scalar(lanes);
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            fill(hRe);
+            fill(hIm);
+            if (format != Format::fp32)
+            {
+                // The kernels see decode(h) * hScale, so the bound uses the same values.
+                for (size_t k = 0; k < bins; ++k)
+                {
+                    compactRe[k] = ComplexMac::encode(format, hRe[k]);
+                    compactIm[k] = ComplexMac::encode(format, hIm[k]);
+                    hRe[k] = ComplexMac::decode(format, compactRe[k]) * hScale;
+                    hIm[k] = ComplexMac::decode(format, compactIm[k]) * hScale;
+                }
+            }
+
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                fill(xRe[l]);
+                fill(xIm[l]);
+                tested[l] = { accRe[l].data(), accIm[l].data(), xRe[l].data(), xIm[l].data() };
+                scalar[l] = { expectedRe[l].data(), expectedIm[l].data(), xRe[l].data(), xIm[l].data() };
+                for (size_t k = 0; k < bins; ++k)
+                    magnitudeSum[l * bins + k] += std::hypot(xRe[l][k], xIm[l][k]) * std::hypot(hRe[k], hIm[k]);
+            }
+
+            if (format == Format::fp32)
+            {
+                ComplexMac::getMultiKernel(isa)(tested.data(), numLanes, hRe.data(), hIm.data(), numBins);
+                ComplexMac::getMultiKernel(ComplexMac::Isa::scalar)(scalar.data(), numLanes, hRe.data(), hIm.data(), numBins);
+            }
+            else
+            {
+                ComplexMac::getCompactMultiKernel(format, isa)(tested.data(), numLanes, compactRe.data(), compactIm.data(),
+                                                               hScale, numBins);
+                ComplexMac::getCompactMultiKernel(format, ComplexMac::Isa::scalar)(scalar.data(), numLanes, compactRe.data(),
+                                                                                   compactIm.data(), hScale, numBins);
+            }
+        }
+
+        double worst = 0.0;
+        for (size_t l = 0; l < lanes; ++l)
+            for (size_t k = 0; k < bins; ++k)
+            {
+                const double difference = std::max(std::abs(static_cast<double>(accRe[l][k]) - expectedRe[l][k]),
+                                                   std::abs(static_cast<double>(accIm[l][k]) - expectedIm[l][k]));
+                worst = std::max(worst, difference / (FLT_EPSILON * magnitudeSum[l * bins + k]));
+            }
+        return worst;
+    }
+
+    // The paths that feed output channel `out` and their inputs, following IRData::Layout.
+    std::vector<std::pair<int, int>> getRoutes(int numPaths, int out)
+    {
+        if (numPaths == 4)
+            return out < 2 ? std::vector<std::pair<int, int>>{ { 0, out }, { 1, 2 + out } } // input, path
+                           : std::vector<std::pair<int, int>>{};
+        return { { out, std::min(out, numPaths - 1) } };
+    }
+
+    // Direct convolution in double precision of input samples from `from` onwards, skipping
+    // silent input samples.
+    Signal convolve(const juce::AudioBuffer<float>& input, int from, const juce::AudioBuffer<float>& ir,
+                    int numChannels, int length)
+    {
+        Signal output(static_cast<size_t>(numChannels), std::vector<double>(static_cast<size_t>(length), 0.0));
+        const int irLength = ir.getNumSamples();
+
+        for (int out = 0; out < numChannels; ++out)
+        {
+            auto& y = output[static_cast<size_t>(out)];
+            for (const auto& [in, path] : getRoutes(ir.getNumChannels(), out))
+            {
+                const float* x = input.getReadPointer(in);
+                const float* h = ir.getReadPointer(path);
+                for (int n = from; n < input.getNumSamples(); ++n)
+                {
+                    if (x[n] == 0.0f)
+                        continue;
+                    const int count = std::min(irLength, length - n);
+                    for (int k = 0; k < count; ++k)
+                        y[static_cast<size_t>(n + k)] += static_cast<double>(x[n]) * h[k];
+                }
+            }
+        }
+
+        return output;
+    }
+
+    double sampleAt(const std::vector<double>& signal, int n)
+    {
+        return n >= 0 && n < static_cast<int>(signal.size()) ? signal[static_cast<size_t>(n)] : 0.0;
+    }
+
+    struct Reference
+    {
+        Signal before; // whole input through the first IR
+        Signal after;  // input from swapAt through the swapped-in IR
+    };
+
+    std::shared_ptr<const IRData> loadIR(const Config& config, const juce::AudioBuffer<float>& ir)
+    {
+        // The loader transforms with the default backend; the engine's own is set separately.
+        FftBackend::setDefaultKind(config.backend);
+        IRLoader loader;
+        loader.setZeroLatency(config.zeroLatency);
+        loader.setOfflinePlanning(config.offline);
+        loader.setSpectrumFormat(config.format);
+        return loader.loadIR(ir, sampleRate, config.preparedBlockSize);
+    }
+
+    struct Result
+    {
+        double errorDb = -400.0; // worst channel
+        int deadlineMisses = 0;
+    };
+
+    // Renders the scenario and returns the worst channel's error relative to the reference, in dB.
+    Result run(const Scenario& scenario, const Config& config, const Reference& reference)
+    {
+        const int numChannels = scenario.numChannels;
+        const int length = scenario.input.getNumSamples();
+
+        ConvolutionEngine engine;
+        engine.setFftBackend(config.backend);
+        engine.setTailScheduling(config.scheduling);
+        if (config.backgroundPartitionSize > 0)
+        {
+            ConvolutionEngine::BackgroundTailOptions options;
+            options.enabled = true;
+            options.minPartitionSize = config.backgroundPartitionSize;
+            options.realtimePriority = -1;
+            engine.setBackgroundTailOptions(options);
+        }
+        engine.setCrossfadeTime(0.0);
+        engine.prepare(sampleRate, config.preparedBlockSize, numChannels);
+        engine.setMix(1.0f);
+        engine.setIR(loadIR(config, scenario.ir));
+        const int latencyBefore = engine.getLatencySamples();
+        int latencyAfter = latencyBefore;
+        int fadeLength = 0;
+
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> randomBlock(1, config.preparedBlockSize);
+        juce::AudioBuffer<float> output(numChannels, length);
+        juce::AudioBuffer<float> block(numChannels, std::max(config.preparedBlockSize, config.hostBlockSize));
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int position = 0; position < length;)
+        {
+            if (config.backgroundPartitionSize > 0)
+            {
+                // Workers get the time the host would give them: no block is due before its time.
+                std::this_thread::sleep_until(start + std::chrono::duration<double>(position / sampleRate));
+                engine.holdTailWorkers(position >= scenario.stallAt && position < scenario.stallAt + scenario.stallLength);
+            }
+
+            if (position == scenario.swapAt)
+            {
+                // Same float round trip as the engine's fade length.
+                engine.setCrossfadeTime(scenario.crossfadeSeconds);
+                fadeLength = static_cast<int>(static_cast<float>(scenario.crossfadeSeconds) * sampleRate);
+                engine.setIR(loadIR(config, scenario.swapIR));
+                latencyAfter = engine.getLatencySamples();
+            }
+
+            int blockSize = config.hostBlockSize > 0 ? config.hostBlockSize : randomBlock(rng);
+            blockSize = std::min(blockSize, length - position);
+            for (const int boundary : { scenario.swapAt, scenario.stallAt, scenario.stallAt + scenario.stallLength })
+                if (position < boundary)
+                    blockSize = std::min(blockSize, boundary - position);
+
+            block.setSize(numChannels, blockSize, false, false, true);
+            for (int ch = 0; ch < numChannels; ++ch)
+                block.copyFrom(ch, 0, scenario.input, ch, position, blockSize);
+            engine.process(block);
+            for (int ch = 0; ch < numChannels; ++ch)
+                output.copyFrom(ch, position, block, ch, 0, blockSize);
+
+            engine.releaseRetiredStates();
+            position += blockSize;
+        }
+
+        Result result;
+        result.deadlineMisses = engine.getTailDeadlineMisses();
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto& before = reference.before[static_cast<size_t>(ch)];
+            double errorEnergy = 0.0;
+            double referenceEnergy = 0.0;
+
+            for (int n = 0; n < length; ++n)
+            {
+                double expected = sampleAt(before, n - latencyBefore);
+                if (scenario.swapAt >= 0 && n >= scenario.swapAt)
+                {
+                    const double gain = fadeLength > 0 ? std::min(1.0, (n - scenario.swapAt) / static_cast<double>(fadeLength)) : 1.0;
+                    const double swapped = sampleAt(reference.after[static_cast<size_t>(ch)], n - latencyAfter);
+                    expected = gain * swapped + (1.0 - gain) * expected;
+                }
+
+                const double error = output.getSample(ch, n) - expected;
+                errorEnergy += error * error;
+                referenceEnergy += expected * expected;
+            }
+
+            if (referenceEnergy > 0.0)
+                result.errorDb = std::max(result.errorDb, 10.0 * std::log10(std::max(errorEnergy, 1.0e-40) / referenceEnergy));
+        }
+
+        return result;
+    }
+
+    // Input of `signalLength` noise samples followed by enough silence for the tail (and the
+    // largest partition's latency) to come out.
+    juce::AudioBuffer<float> makeInput(int numChannels, int signalLength, int irLength, unsigned seed)
+    {
+        auto input = makeNoise(numChannels, signalLength + irLength + 2 * 8192, seed);
+        for (int ch = 0; ch < numChannels; ++ch)
+            input.clear(ch, signalLength, input.getNumSamples() - signalLength);
+        return input;
+    }
+
+    std::vector<Scenario> makeScenarios()
+    {
+        std::vector<Scenario> scenarios;
+
+        const auto add = [&](const char* name, int numChannels, juce::AudioBuffer<float> ir, int signalLength) -> Scenario& {
+            Scenario scenario;
+            scenario.name = name;
+            scenario.numChannels = numChannels;
+            scenario.input = makeInput(numChannels, signalLength, ir.getNumSamples(), 11u + static_cast<unsigned>(scenarios.size()));
+            scenario.ir = std::move(ir);
+            scenarios.push_back(std::move(scenario));
+            return scenarios.back();
+        };
+
+        add("unit impulse", 1, makeImpulses(1, 1, { 0 }, 1.0f), 4000);
+        add("delayed impulses", 2, makeImpulses(2, 6000, { 4999, 17 }, 0.5f), 12000);
+        add("random 40 taps", 1, makeNoise(1, 40, 1), 4000);
+        add("random 3000 stereo", 2, makeNoise(2, 3000, 2, 0.02), 12000);
+        add("random 20000", 1, makeNoise(1, 20000, 3, 0.1), 30000);
+        add("true stereo 8000", 2, makeNoise(4, 8000, 4, 0.05), 20000);
+        add("stereo IR on 3 channels", 3, makeNoise(2, 5000, 5, 0.03), 12000);
+
+        // Long enough a gap for the engine to go to sleep, then input resumes.
+        auto& gap = add("random 20000 with gap", 1, makeNoise(1, 20000, 6, 0.1), 16000);
+        {
+            const auto burst = makeNoise(1, 16000, 60);
+            gap.input.setSize(1, gap.input.getNumSamples() + 80000 + 16000, true, true);
+            gap.input.copyFrom(0, 96000, burst, 0, 0, 16000);
+        }
+
+        auto& swap = add("swap 8000 -> 12000", 2, makeNoise(2, 8000, 7, 0.05), 40000);
+        swap.swapIR = makeNoise(2, 12000, 8, 0.08);
+        swap.swapAt = 20000;
+
+        auto& fade = add("swap with 10 ms crossfade", 2, makeNoise(2, 12000, 9, 0.08), 40000);
+        fade.swapIR = makeNoise(2, 3000, 10, 0.02);
+        fade.swapAt = 20000;
+        fade.crossfadeSeconds = 0.01;
+
+        // With 256-sample blocks the 8192 tier covers IR samples 16384 to 98304, one partition per
+        // 8192 samples. The worker runs the burst's first two tier blocks, then is held while four
+        // silent blocks fill its job ring and a fifth is dropped. Those jobs' results are lost, so
+        // the IR is silent over the partitions they would have applied to the burst (2 to 6). The
+        // burst's later partitions are applied after the stall and are only right if the worker's
+        // delay line advanced for the dropped block; input resuming after the stall must come out
+        // exact as well.
+        auto& overload = add("tail overload recovery", 1, makeNoise(1, 96000, 13, 1.0), 8000);
+        {
+            overload.ir.clear(0, 32768, 73728 - 32768);
+            const auto burst = makeNoise(1, 4000, 130);
+            overload.input.copyFrom(0, 62000, burst, 0, 0, 4000);
+            overload.stallAt = 20000;
+            overload.stallLength = 40000;
+        }
+
+        return scenarios;
+    }
+
+    std::vector<Config> makeConfigs()
+    {
+        using Kind = FftBackend::Kind;
+        using Scheduling = ConvolutionEngine::TailScheduling;
+        using Format = ComplexMac::SpectrumFormat;
+
+        std::vector<Config> configs;
+        const auto add = [&](Config config) { configs.push_back(config); };
+
+        add({ "block 32", 32, 32 });
+        add({ "block 100 (odd)", 100, 100 });
+        add({ "block 512", 512, 512 });
+        add({ "block 4096", 4096, 4096 });
+        add({ "random 1..1024", 1024, 0 });
+        add({ "1000 on prepared 256", 256, 1000 });
+        add({ "zero latency 32", 32, 32, Kind::simd, Scheduling::distributed, true });
+        add({ "zero latency 100", 100, 100, Kind::simd, Scheduling::distributed, true });
+        add({ "zero latency random", 512, 0, Kind::simd, Scheduling::distributed, true });
+        add({ "juce fft 256", 256, 256, Kind::juce });
+        add({ "inhouse fft 256", 256, 256, Kind::inHouse });
+        add({ "immediate 100", 100, 100, Kind::simd, Scheduling::immediate });
+        add({ "immediate random", 1024, 0, Kind::simd, Scheduling::immediate });
+        add({ "fp16 tails 256", 256, 256, Kind::simd, Scheduling::distributed, false, false, Format::fp16, fp16BudgetDb });
+        add({ "bf16 tails 256", 256, 256, Kind::simd, Scheduling::distributed, false, false, Format::bf16, bf16BudgetDb });
+        add({ "offline planning", 1024, 1024, Kind::simd, Scheduling::distributed, false, true });
+        add({ "background tails 256", 256, 256, Kind::simd, Scheduling::distributed, false, false, Format::fp32,
+              fp32BudgetDb, 8192 });
+
+        return configs;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            std::printf("usage: EngineAccuracy [--filter text]\n");
+            return 1;
+        }
+    }
+
+    const auto matches = [filter](const char* name) { return filter == nullptr || std::strstr(name, filter) != nullptr; };
+    const auto scenarios = makeScenarios();
+    const auto configs = makeConfigs();
+
+    int runs = 0;
+    int failures = 0;
+
+    using Isa = ComplexMac::Isa;
+    using Format = ComplexMac::SpectrumFormat;
+    std::printf("%-26s %-22s %10s %10s\n", "MAC kernel", "format, lanes", "error eps", "budget eps");
+    for (const auto isa : { Isa::sse2, Isa::avx2, Isa::avx512, Isa::neon })
+    {
+        if (ComplexMac::getMultiKernel(isa) == nullptr || !(matches("MAC kernel") || matches(ComplexMac::getIsaName(isa))))
+            continue;
+
+        for (const auto format : { Format::fp32, Format::fp16, Format::bf16 })
+            for (const int numLanes : { 1, 3 })
+            {
+                const double error = checkMacKernel(isa, format, numLanes);
+                const bool passed = error <= macBudgetEpsilons;
+                failures += passed ? 0 : 1;
+                ++runs;
+
+                const char* formatName = format == Format::fp32 ? "fp32" : format == Format::fp16 ? "fp16" : "bf16";
+                const auto label = juce::String(formatName) + ", " + juce::String(numLanes);
+                std::printf("%-26s %-22s %10.2f %10.1f %s\n", ComplexMac::getIsaName(isa), label.toRawUTF8(), error,
+                            macBudgetEpsilons, passed ? "ok" : "FAIL");
+            }
+    }
+
+    std::printf("\n%-26s %-22s %10s %10s\n", "scenario", "configuration", "error dB", "budget dB");
+
+    for (const auto& scenario : scenarios)
+    {
+        std::vector<const Config*> selected;
+        for (const auto& config : configs)
+            if (matches(scenario.name) || matches(config.name))
+                selected.push_back(&config);
+        if (selected.empty())
+            continue;
+
+        Reference reference;
+        const int length = scenario.input.getNumSamples();
+        reference.before = convolve(scenario.input, 0, scenario.ir, scenario.numChannels, length);
+        if (scenario.swapAt >= 0)
+            reference.after = convolve(scenario.input, scenario.swapAt, scenario.swapIR, scenario.numChannels, length);
+
+        for (const auto* config : selected)
+        {
+            const auto result = run(scenario, *config, reference);
+            // A stall that caused no misses did not test the recovery.
+            const bool overloaded = scenario.stallAt < 0 || config->backgroundPartitionSize == 0 || result.deadlineMisses > 0;
+            const bool passed = result.errorDb <= config->budgetDb && overloaded;
+            failures += passed ? 0 : 1;
+            ++runs;
+            std::printf("%-26s %-22s %10.1f %10.1f %s", scenario.name, config->name, result.errorDb, config->budgetDb,
+                        passed ? "ok" : "FAIL");
+            if (result.deadlineMisses > 0 || !overloaded)
+                std::printf(" (%d deadline misses)", result.deadlineMisses);
+            std::printf("\n");
+        }
+    }
+
+    std::printf("%d of %d runs within budget\n", runs - failures, runs);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,402 @@
+// Realtime benchmark for ConvolutionEngine: drives process() with host-sized blocks of noise over a
+// matrix of IR lengths, block sizes, channel counts and FFT backends, with juce::dsp::Convolution
+// (zero latency, its default) as a baseline. For each configuration it reports mean, p99 and worst
+// ns per block and the realtime factor (block duration / mean time per block).
+//
+//     EngineBenchmark [options]
+//
+//     --ir-seconds a,b,...   IR lengths in seconds (default 0.1,1,6,20)
+//     --blocks a,b,...       host block sizes (default 32,128,512,4096)
+//     --channels a,b,...     bus channels; the IR has min(channels, 2) paths (default 1,2)
+//     --backends a,b,...     FFT backends for ConvolutionEngine (default juce,inhouse,simd)
+//     --immediate            run tail tiers whole in the callback their block completes (default
+//                            spreads them over the following period, as the plugin does)
+//     --no-juce              skip the juce::dsp::Convolution baseline
+//     --seconds S            audio timed per configuration (default 4)
+//     --max-wall S           wall-clock cap per configuration, at least 32 blocks run (default 2)
+//     --json file            write the results as JSON
+//     --baseline file        compare against a previous --json file
+//     --tolerance P          percent increase in mean or p99 counted as a regression (default 15)
+//
+// A compared run exits with status 2 if any configuration regressed, so CI can gate on it. Worst
+// case is reported but not compared: a single preemption dominates it.
+
+#include "BenchmarkIRs.h"
+#include "ComplexMac.h"
+#include "ConvolutionEngine.h"
+#include "FftBackend.h"
+#include "IRLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <juce_dsp/juce_dsp.h>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int warmUpBlocks = 16;
+    constexpr int minTimedBlocks = 32;
+
+    struct Options
+    {
+        std::vector<double> irSeconds{ 0.1, 1.0, 6.0, 20.0 };
+        std::vector<int> blockSizes{ 32, 128, 512, 4096 };
+        std::vector<int> channelCounts{ 1, 2 };
+        std::vector<FftBackend::Kind> backends{ std::begin(FftBackend::allKinds), std::end(FftBackend::allKinds) };
+        ConvolutionEngine::TailScheduling scheduling = ConvolutionEngine::TailScheduling::distributed;
+        bool juceBaseline = true;
+        double seconds = 4.0;
+        double maxWallSeconds = 2.0;
+        juce::File jsonFile;
+        juce::File baselineFile;
+        double tolerancePercent = 15.0;
+    };
+
+    struct Result
+    {
+        juce::String engine;
+        juce::String backend;
+        juce::String scheduling;
+        double irSeconds = 0.0;
+        int blockSize = 0;
+        int channels = 0;
+        int latency = 0;
+        int numBlocks = 0;
+        double meanNs = 0.0;
+        double p99Ns = 0.0;
+        double worstNs = 0.0;
+        double realtimeFactor = 0.0;
+
+        juce::String getKey() const
+        {
+            return engine + "|" + backend + "|" + scheduling + "|" + juce::String(irSeconds) + "|" + juce::String(blockSize) + "|"
+                 + juce::String(channels);
+        }
+    };
+
+    void printUsage()
+    {
+        std::printf("usage: EngineBenchmark [--ir-seconds a,b] [--blocks a,b] [--channels a,b] [--backends a,b]\n"
+                    "                       [--immediate] [--no-juce] [--seconds S] [--max-wall S] [--json file]\n"
+                    "                       [--baseline file] [--tolerance percent]\n");
+    }
+
+    template <typename Value, typename Parse>
+    bool parseList(const char* text, std::vector<Value>& values, Parse&& parse)
+    {
+        values.clear();
+        for (const auto& token : juce::StringArray::fromTokens(juce::String(text), ",", ""))
+        {
+            Value value;
+            if (!parse(token.trim(), value))
+                return false;
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options)
+    {
+        const auto parsePositiveInt = [](const juce::String& token, int& value) {
+            value = token.getIntValue();
+            return value > 0;
+        };
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            bool ok = true;
+
+            if (std::strcmp(arg, "--ir-seconds") == 0 && hasValue)
+                ok = parseList(argv[++i], options.irSeconds, [](const juce::String& token, double& value) {
+                    value = token.getDoubleValue();
+                    return value > 0.0;
+                });
+            else if (std::strcmp(arg, "--blocks") == 0 && hasValue)
+                ok = parseList(argv[++i], options.blockSizes, parsePositiveInt);
+            else if (std::strcmp(arg, "--channels") == 0 && hasValue)
+                ok = parseList(argv[++i], options.channelCounts, parsePositiveInt);
+            else if (std::strcmp(arg, "--backends") == 0 && hasValue)
+                ok = parseList(argv[++i], options.backends, [](const juce::String& token, FftBackend::Kind& kind) {
+                    return FftBackend::parseName(token.toRawUTF8(), kind);
+                });
+            else if (std::strcmp(arg, "--immediate") == 0)
+                options.scheduling = ConvolutionEngine::TailScheduling::immediate;
+            else if (std::strcmp(arg, "--no-juce") == 0)
+                options.juceBaseline = false;
+            else if (std::strcmp(arg, "--seconds") == 0 && hasValue)
+                options.seconds = std::atof(argv[++i]);
+            else if (std::strcmp(arg, "--max-wall") == 0 && hasValue)
+                options.maxWallSeconds = std::atof(argv[++i]);
+            else if (std::strcmp(arg, "--json") == 0 && hasValue)
+                options.jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+            else if (std::strcmp(arg, "--baseline") == 0 && hasValue)
+                options.baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+            else if (std::strcmp(arg, "--tolerance") == 0 && hasValue)
+                options.tolerancePercent = std::atof(argv[++i]);
+            else
+                ok = false;
+
+            if (!ok)
+            {
+                std::fprintf(stderr, "bad or incomplete option: %s\n", arg);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Times `process` once per block over a looping noise buffer. Input is copied in outside the
+    // timed region, so only the processor itself is measured.
+    template <typename Process>
+    void timeBlocks(Result& result, const Options& options, Process&& process)
+    {
+        const int blockSize = result.blockSize;
+        const int channels = result.channels;
+        const int maxBlocks = std::max(minTimedBlocks, static_cast<int>(options.seconds * sampleRate / blockSize));
+
+        std::mt19937 rng(99);
+        std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+        const int sourceLength = static_cast<int>(sampleRate);
+        juce::AudioBuffer<float> source(channels, sourceLength + blockSize);
+        for (int ch = 0; ch < channels; ++ch)
+            for (int n = 0; n < source.getNumSamples(); ++n)
+                source.setSample(ch, n, noise(rng));
+
+        juce::AudioBuffer<float> buffer(channels, blockSize);
+        std::vector<double> times;
+        times.reserve(static_cast<size_t>(maxBlocks));
+
+        const auto wallStart = std::chrono::steady_clock::now();
+        int position = 0;
+        for (int b = 0; b < warmUpBlocks + maxBlocks; ++b)
+        {
+            for (int ch = 0; ch < channels; ++ch)
+                buffer.copyFrom(ch, 0, source, ch, position, blockSize);
+            position = (position + blockSize) % sourceLength;
+
+            const auto start = std::chrono::steady_clock::now();
+            process(buffer);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+            if (b < warmUpBlocks)
+                continue;
+
+            times.push_back(elapsed.count());
+            const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+            if (static_cast<int>(times.size()) >= minTimedBlocks && wall.count() > options.maxWallSeconds)
+                break;
+        }
+
+        double sum = 0.0;
+        for (double t : times)
+            sum += t;
+
+        result.numBlocks = static_cast<int>(times.size());
+        result.meanNs = sum / static_cast<double>(times.size());
+        result.worstNs = *std::max_element(times.begin(), times.end());
+        auto p99 = times.begin() + static_cast<std::ptrdiff_t>(std::min(times.size() - 1, times.size() * 99 / 100));
+        std::nth_element(times.begin(), p99, times.end());
+        result.p99Ns = *p99;
+        result.realtimeFactor = (blockSize / sampleRate * 1.0e9) / result.meanNs;
+    }
+
+    Result runEngine(const juce::AudioBuffer<float>& ir, FftBackend::Kind kind, double irSeconds, int blockSize,
+                     int channels, const Options& options)
+    {
+        const bool immediate = options.scheduling == ConvolutionEngine::TailScheduling::immediate;
+        Result result{ "ConvolutionEngine", FftBackend::getName(kind), immediate ? "immediate" : "distributed",
+                       irSeconds, blockSize, channels };
+
+        // The loader transforms the IR with the default backend; all backends share one layout, but
+        // matching them keeps each run self-contained.
+        FftBackend::setDefaultKind(kind);
+        IRLoader loader;
+        const auto data = loader.loadIR(ir, sampleRate, blockSize);
+
+        ConvolutionEngine engine;
+        engine.setFftBackend(kind);
+        engine.setCrossfadeTime(0.0);
+        engine.setTailScheduling(options.scheduling);
+        engine.prepare(sampleRate, blockSize, channels);
+        engine.setIR(data);
+        engine.setMix(1.0f);
+        result.latency = engine.getLatencySamples();
+
+        timeBlocks(result, options, [&](juce::AudioBuffer<float>& buffer) { engine.process(buffer); });
+        return result;
+    }
+
+    Result runJuceConvolution(const juce::AudioBuffer<float>& ir, double irSeconds, int blockSize, int channels,
+                              const Options& options)
+    {
+        Result result{ "juce::dsp::Convolution", "-", "-", irSeconds, blockSize, channels };
+
+        juce::dsp::Convolution convolution;
+        convolution.prepare({ sampleRate, static_cast<juce::uint32>(blockSize), static_cast<juce::uint32>(channels) });
+
+        juce::AudioBuffer<float> irCopy(ir);
+        convolution.loadImpulseResponse(std::move(irCopy), sampleRate,
+                                        ir.getNumChannels() > 1 ? juce::dsp::Convolution::Stereo::yes
+                                                                : juce::dsp::Convolution::Stereo::no,
+                                        juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+
+        // The IR is prepared on Convolution's own background thread and swapped in by process().
+        juce::AudioBuffer<float> silence(channels, blockSize);
+        for (int attempt = 0; attempt < 10000 && convolution.getCurrentIRSize() != ir.getNumSamples(); ++attempt)
+        {
+            silence.clear();
+            juce::dsp::AudioBlock<float> block(silence);
+            convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        result.latency = convolution.getLatency();
+
+        timeBlocks(result, options, [&](juce::AudioBuffer<float>& buffer) {
+            juce::dsp::AudioBlock<float> block(buffer);
+            convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+        });
+        return result;
+    }
+
+    void printResult(const Result& result)
+    {
+        std::printf("%-22s %-8s %6.1f %6d %3d %7d %12.0f %12.0f %12.0f %10.1fx\n", result.engine.toRawUTF8(),
+                    result.backend.toRawUTF8(), result.irSeconds, result.blockSize, result.channels, result.latency,
+                    result.meanNs, result.p99Ns, result.worstNs, result.realtimeFactor);
+    }
+
+    juce::var toJson(const std::vector<Result>& results)
+    {
+        juce::Array<juce::var> list;
+        for (const auto& result : results)
+        {
+            juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+            entry->setProperty("engine", result.engine);
+            entry->setProperty("backend", result.backend);
+            entry->setProperty("scheduling", result.scheduling);
+            entry->setProperty("irSeconds", result.irSeconds);
+            entry->setProperty("blockSize", result.blockSize);
+            entry->setProperty("channels", result.channels);
+            entry->setProperty("latency", result.latency);
+            entry->setProperty("blocks", result.numBlocks);
+            entry->setProperty("meanNs", result.meanNs);
+            entry->setProperty("p99Ns", result.p99Ns);
+            entry->setProperty("worstNs", result.worstNs);
+            entry->setProperty("realtimeFactor", result.realtimeFactor);
+            list.add(juce::var(entry.get()));
+        }
+
+        juce::DynamicObject::Ptr root = new juce::DynamicObject();
+        root->setProperty("version", 1);
+        root->setProperty("sampleRate", sampleRate);
+        root->setProperty("isa", ComplexMac::getIsaName(ComplexMac::getActiveIsa()));
+        root->setProperty("cpus", juce::SystemStats::getNumCpus());
+        root->setProperty("results", list);
+        return juce::var(root.get());
+    }
+
+    // Returns the number of regressions; configurations missing from either side are listed only.
+    int compareWithBaseline(const std::vector<Result>& results, const juce::File& baselineFile, double tolerancePercent)
+    {
+        const auto baseline = juce::JSON::parse(baselineFile);
+        const auto* entries = baseline["results"].getArray();
+        if (entries == nullptr)
+        {
+            std::fprintf(stderr, "cannot read baseline %s\n", baselineFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        std::printf("\ncompared with %s (tolerance %.0f%%):\n", baselineFile.getFullPathName().toRawUTF8(), tolerancePercent);
+        const double limit = 1.0 + tolerancePercent / 100.0;
+        int regressions = 0;
+
+        for (const auto& result : results)
+        {
+            const auto match = std::find_if(entries->begin(), entries->end(), [&](const juce::var& entry) {
+                Result key{ entry["engine"].toString(), entry["backend"].toString(), entry["scheduling"].toString(),
+                            static_cast<double>(entry["irSeconds"]), static_cast<int>(entry["blockSize"]),
+                            static_cast<int>(entry["channels"]) };
+                return key.getKey() == result.getKey();
+            });
+
+            if (match == entries->end())
+            {
+                std::printf("  new       %s\n", result.getKey().toRawUTF8());
+                continue;
+            }
+
+            const double meanRatio = result.meanNs / static_cast<double>((*match)["meanNs"]);
+            const double p99Ratio = result.p99Ns / static_cast<double>((*match)["p99Ns"]);
+            const bool regressed = meanRatio > limit || p99Ratio > limit;
+            regressions += regressed ? 1 : 0;
+            std::printf("  %-9s %s  mean x%.2f  p99 x%.2f\n", regressed ? "REGRESSED" : "ok",
+                        result.getKey().toRawUTF8(), meanRatio, p99Ratio);
+        }
+
+        std::printf("%d regression(s)\n", regressions);
+        return regressions;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArguments(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::printf("MAC: %s, %d CPUs, %.0f Hz, %s tail scheduling\n", ComplexMac::getIsaName(ComplexMac::getActiveIsa()),
+                juce::SystemStats::getNumCpus(), sampleRate,
+                options.scheduling == ConvolutionEngine::TailScheduling::immediate ? "immediate" : "distributed");
+    std::printf("%-22s %-8s %6s %6s %3s %7s %12s %12s %12s %11s\n", "engine", "backend", "ir s", "block", "ch",
+                "latency", "mean ns", "p99 ns", "worst ns", "realtime");
+
+    std::vector<Result> results;
+    for (double irSeconds : options.irSeconds)
+    {
+        for (int channels : options.channelCounts)
+        {
+            const auto ir = BenchmarkIRs::makeDecayingNoise(irSeconds, sampleRate, std::min(channels, 2));
+
+            for (int blockSize : options.blockSizes)
+            {
+                for (auto kind : options.backends)
+                {
+                    results.push_back(runEngine(ir, kind, irSeconds, blockSize, channels, options));
+                    printResult(results.back());
+                }
+
+                // juce::dsp::Convolution handles mono and stereo only.
+                if (options.juceBaseline && channels <= 2)
+                {
+                    results.push_back(runJuceConvolution(ir, irSeconds, blockSize, channels, options));
+                    printResult(results.back());
+                }
+            }
+        }
+    }
+
+    if (options.jsonFile != juce::File())
+    {
+        if (!options.jsonFile.replaceWithText(juce::JSON::toString(toJson(results))))
+            std::fprintf(stderr, "cannot write %s\n", options.jsonFile.getFullPathName().toRawUTF8());
+        else
+            std::printf("\nwrote %s\n", options.jsonFile.getFullPathName().toRawUTF8());
+    }
+
+    if (options.baselineFile != juce::File())
+        return compareWithBaseline(results, options.baselineFile, options.tolerancePercent) > 0 ? 2 : 0;
+
+    return 0;
+}
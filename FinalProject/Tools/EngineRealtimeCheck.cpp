@@ -0,0 +1,193 @@
+// Real-time safety check: drives ConvolutionEngine the way the plugin does — prepare, an IR load,
+// then many audio callbacks on their own thread while IRs are swapped in with crossfades, mix and
+// trim move, and retired states are collected from another thread — and fails if any callback (or
+// tail worker job) allocated, freed or locked a mutex. Built with CONVOLUTION_REALTIME_CHECK=1, so
+// every violation is reported with its call stack (see Common/RealtimeCheck.h).
+//
+//     EngineRealtimeCheck [numBlocks]      default 4000 callbacks per configuration
+//
+// Each configuration covers one FFT backend with immediate or distributed tails, with and without
+// a zero-latency head, and with background tail workers. Exits with status 1 on any violation.
+
+#include "ConvolutionEngine.h"
+#include "FftBackend.h"
+#include "IRLoader.h"
+#include "RealtimeCheck.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+    constexpr int preparedBlockSize = 256;
+
+    struct Config
+    {
+        const char* name;
+        FftBackend::Kind backend = FftBackend::Kind::simd;
+        ConvolutionEngine::TailScheduling scheduling = ConvolutionEngine::TailScheduling::distributed;
+        bool zeroLatency = false;
+        bool background = false;
+    };
+
+    juce::AudioBuffer<float> makeImpulseResponse(int numPaths, int length, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+        juce::AudioBuffer<float> ir(numPaths, length);
+        for (int ch = 0; ch < numPaths; ++ch)
+            for (int n = 0; n < length; ++n)
+                ir.setSample(ch, n, noise(rng) * std::exp(-4.0f * n / length));
+        return ir;
+    }
+
+    // One plugin lifetime: prepare and a first IR with audio stopped, then callbacks on an audio
+    // thread while this thread keeps loading IRs and collecting retired states. Returns the
+    // number of IRs loaded while audio ran.
+    int run(const Config& config, int numBlocks)
+    {
+        // Mono, stereo and true-stereo IRs of growing length, so swaps change the channel layout
+        // and the number of tiers as well.
+        const juce::AudioBuffer<float> irs[] = { makeImpulseResponse(2, 30000, 1), makeImpulseResponse(1, 120, 2),
+                                                 makeImpulseResponse(4, 60000, 3), makeImpulseResponse(2, 9000, 4) };
+
+        FftBackend::setDefaultKind(config.backend);
+        IRLoader loader;
+        loader.setZeroLatency(config.zeroLatency);
+
+        ConvolutionEngine engine;
+        engine.setFftBackend(config.backend);
+        engine.setTailScheduling(config.scheduling);
+        if (config.background)
+        {
+            ConvolutionEngine::BackgroundTailOptions options;
+            options.enabled = true;
+            options.numThreads = 2;
+            options.minPartitionSize = 1024;
+            options.realtimePriority = -1;
+            engine.setBackgroundTailOptions(options);
+        }
+        engine.setCrossfadeTime(0.05);
+        engine.prepare(sampleRate, preparedBlockSize, numChannels);
+        engine.setIR(loader.loadIR(irs[0], sampleRate, preparedBlockSize));
+
+        std::atomic<bool> audioRunning{ true };
+        std::thread audioThread([&] {
+            // Buffers a host would own, allocated before the callbacks start.
+            juce::AudioBuffer<float> source(numChannels, 1 << 16);
+            std::mt19937 rng(5);
+            std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int n = 0; n < source.getNumSamples(); ++n)
+                    source.setSample(ch, n, noise(rng));
+
+            constexpr int hostBlockSizes[] = { 256, 64, 1, 255, 100, 1000, 256, 17 };
+            constexpr int maxHostBlockSize = 1000;
+            juce::AudioBuffer<float> buffer(numChannels, maxHostBlockSize);
+            juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> dryWet;
+            dryWet.reset(sampleRate, 0.05);
+            dryWet.setCurrentAndTargetValue(0.5f);
+
+            int position = 0;
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                const int blockSize = hostBlockSizes[block % std::size(hostBlockSizes)];
+                buffer.setSize(numChannels, blockSize, false, false, true);
+
+                // Stretches of silence let the engine fall asleep and wake up again.
+                const bool silent = (block / 500) % 4 == 3;
+                for (int ch = 0; ch < numChannels; ++ch)
+                    if (silent)
+                        buffer.clear(ch, 0, blockSize);
+                    else
+                        buffer.copyFrom(ch, 0, source, ch, position, blockSize);
+                position = (position + blockSize) % (source.getNumSamples() - maxHostBlockSize);
+
+                // What processBlock does, inside the same kind of section.
+                {
+                    const RealtimeCheck::ScopedRealtimeSection realtimeSection;
+                    if (block % 300 == 0)
+                        dryWet.setTargetValue(block % 600 == 0 ? 0.2f : 0.9f);
+                    engine.setMix(dryWet.getNextValue());
+                    engine.setOutputTrim(static_cast<float>(block % 7) - 3.0f);
+                    engine.process(buffer);
+                }
+
+                // Loose pacing, so the loader thread gets its swaps in.
+                if (block % 8 == 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            audioRunning = false;
+        });
+
+        int load = 0;
+        while (audioRunning)
+        {
+            ++load;
+            engine.setIR(loader.loadIR(irs[load % std::size(irs)], sampleRate, preparedBlockSize));
+            for (int i = 0; i < 10 && audioRunning; ++i)
+            {
+                engine.releaseRetiredStates();
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+
+        audioThread.join();
+        engine.releaseRetiredStates();
+        return load;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (!RealtimeCheck::isEnabled())
+    {
+        RealtimeCheck::report();
+        return 1;
+    }
+
+    const int numBlocks = argc > 1 ? std::max(1, std::atoi(argv[1])) : 4000;
+
+    using Kind = FftBackend::Kind;
+    using Scheduling = ConvolutionEngine::TailScheduling;
+    const Config configs[] = {
+        { "juce fft, distributed", Kind::juce },
+        { "inhouse fft, distributed", Kind::inHouse },
+        { "simd fft, distributed", Kind::simd },
+        { "simd fft, immediate", Kind::simd, Scheduling::immediate },
+        { "simd fft, zero latency", Kind::simd, Scheduling::distributed, true },
+        { "simd fft, background tails", Kind::simd, Scheduling::distributed, false, true },
+    };
+
+    int failures = 0;
+    for (const auto& config : configs)
+    {
+        RealtimeCheck::reset();
+        const int loads = run(config, numBlocks);
+
+        const int violations = RealtimeCheck::getNumViolations();
+        std::printf("%-28s %3d IR loads  ", config.name, loads);
+        if (violations == 0)
+        {
+            std::printf("ok\n");
+        }
+        else
+        {
+            std::printf("%d violation(s)\n", violations);
+            std::fflush(stdout);
+            RealtimeCheck::report();
+            ++failures;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+// A/B benchmark for the FFT backends: nanoseconds per forward and per inverse transform for every
+// backend and size, plus each backend's round-trip error against the first one listed.
+//
+//     FftBenchmark [minOrder [maxOrder]]      defaults: 6 .. 15 (64 .. 32768 points)
+
+#include "FftBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr int numRuns = 5;
+
+    // Best of numRuns timings of `iterations` calls, in nanoseconds per call. The best run is the
+    // one least disturbed by the OS, which is what an A/B between backends needs.
+    template <typename Fn>
+    double timePerCall(int iterations, Fn&& fn)
+    {
+        double best = 1.0e300;
+        for (int run = 0; run < numRuns; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+                fn();
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count() / iterations);
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int minOrder = argc > 1 ? std::atoi(argv[1]) : 6;
+    const int maxOrder = argc > 2 ? std::atoi(argv[2]) : 15;
+
+    std::printf("default backend: %s\n", FftBackend::getName(FftBackend::getDefaultKind()));
+    std::printf("%-8s %7s %12s %12s %14s\n", "backend", "size", "forward ns", "inverse ns", "vs first dB");
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    for (int order = minOrder; order <= maxOrder; ++order)
+    {
+        const int size = 1 << order;
+        const int bins = size / 2 + 1;
+        const int iterations = std::max(16, (1 << 22) / size);
+
+        std::vector<float> input(static_cast<size_t>(size));
+        for (auto& sample : input)
+            sample = dist(rng);
+
+        std::vector<float> reference;
+
+        for (auto kind : FftBackend::allKinds)
+        {
+            const auto fft = FftBackend::get(kind, order);
+            std::vector<float> real(static_cast<size_t>(bins)), imag(static_cast<size_t>(bins));
+            std::vector<float> output(static_cast<size_t>(size));
+            std::vector<float> work(static_cast<size_t>(fft->getWorkSize()));
+
+            const double forwardNs = timePerCall(iterations, [&] {
+                fft->forward(input.data(), size, real.data(), imag.data(), work.data());
+            });
+            const double inverseNs = timePerCall(iterations, [&] {
+                fft->inverse(real.data(), imag.data(), output.data(), work.data());
+            });
+
+            fft->forward(input.data(), size, real.data(), imag.data(), work.data());
+            fft->inverse(real.data(), imag.data(), output.data(), work.data());
+
+            std::printf("%-8s %7d %12.1f %12.1f ", FftBackend::getName(kind), size, forwardNs, inverseNs);
+
+            // Differences between backends are rounding only; anything near 0 dB is a bug.
+            if (reference.empty())
+            {
+                reference = output;
+                std::printf("%14s\n", "reference");
+                continue;
+            }
+
+            double error = 0.0, energy = 0.0;
+            for (int n = 0; n < size; ++n)
+            {
+                const double diff = static_cast<double>(output[static_cast<size_t>(n)]) - reference[static_cast<size_t>(n)];
+                error += diff * diff;
+                energy += static_cast<double>(reference[static_cast<size_t>(n)]) * reference[static_cast<size_t>(n)];
+            }
+            std::printf("%14.1f\n", error > 0.0 ? 10.0 * std::log10(error / energy) : -300.0);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+// Load-time benchmark for IRLoader: writes decaying-noise IRs of each length to temporary 24-bit
+// WAV files and times loading them with 1, 2, 4, ... load threads, so the scaling of the parallel
+// decode and transform with core count shows directly. For each configuration it reports the best
+// of several runs of a full file load, an in-memory load of the same samples (transforms only),
+// and a progressive file load's time to first audio and to the complete IR.
+//
+//     IRLoadBenchmark [options]
+//
+//     --ir-seconds a,b,...   IR lengths in seconds (default 1,10,60)
+//     --threads a,b,...      load threads, counting the loading thread (default powers of two up
+//                            to one per core)
+//     --channels N           IR channels (default 2)
+//     --block N              host block size the IRs are planned for (default 256)
+//     --runs N               runs per configuration, the best is reported (default 3)
+//
+// The disk cache is off, so every load decodes and transforms the whole IR.
+
+#include "BenchmarkIRs.h"
+#include "FftBackend.h"
+#include "IRCache.h"
+#include "IRLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    struct Options
+    {
+        std::vector<double> irSeconds{ 1.0, 10.0, 60.0 };
+        std::vector<int> threadCounts; // empty: powers of two up to the loader's default
+        int channels = 2;
+        int blockSize = 256;
+        int runs = 3;
+    };
+
+    struct Timing
+    {
+        bool loaded = false;
+        double fileMs = 0.0;
+        double memoryMs = 0.0;
+        double firstAudioMs = 0.0;
+        double completeMs = 0.0;
+    };
+
+    void printUsage()
+    {
+        std::printf("usage: IRLoadBenchmark [--ir-seconds a,b] [--threads a,b] [--channels N] [--block N] [--runs N]\n");
+    }
+
+    template <typename Value, typename Parse>
+    bool parseList(const char* text, std::vector<Value>& values, Parse&& parse)
+    {
+        values.clear();
+        for (const auto& token : juce::StringArray::fromTokens(juce::String(text), ",", ""))
+        {
+            Value value;
+            if (!parse(token.trim(), value))
+                return false;
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char* arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            bool ok = true;
+
+            if (std::strcmp(arg, "--ir-seconds") == 0 && hasValue)
+                ok = parseList(argv[++i], options.irSeconds, [](const juce::String& token, double& value) {
+                    value = token.getDoubleValue();
+                    return value > 0.0;
+                });
+            else if (std::strcmp(arg, "--threads") == 0 && hasValue)
+                ok = parseList(argv[++i], options.threadCounts, [](const juce::String& token, int& value) {
+                    value = token.getIntValue();
+                    return value > 0;
+                });
+            else if (std::strcmp(arg, "--channels") == 0 && hasValue)
+                ok = (options.channels = std::atoi(argv[++i])) > 0;
+            else if (std::strcmp(arg, "--block") == 0 && hasValue)
+                ok = (options.blockSize = std::atoi(argv[++i])) > 0;
+            else if (std::strcmp(arg, "--runs") == 0 && hasValue)
+                ok = (options.runs = std::atoi(argv[++i])) > 0;
+            else
+                ok = false;
+
+            if (!ok)
+            {
+                std::fprintf(stderr, "bad or incomplete option: %s\n", arg);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& ir)
+    {
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        if (stream != nullptr)
+            writer.reset(wav.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(ir.getNumChannels()), 24, {}, 0));
+        if (!writer)
+            return false;
+
+        stream.release(); // owned by the writer now
+        return writer->writeFromAudioSampleBuffer(ir, 0, ir.getNumSamples());
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Each load gets a fresh loader and drops its IR before the next one, so the memory cache never
+    // hands back an earlier result; destroying the loader waits for its progressive fill.
+    Timing timeLoads(const Options& options, const juce::File& file, const juce::AudioBuffer<float>& ir, int threads)
+    {
+        Timing best;
+        for (int run = 0; run < options.runs; ++run)
+        {
+            Timing timing;
+            timing.loaded = true;
+            {
+                IRLoader loader;
+                loader.setNumLoadThreads(threads);
+                const auto start = std::chrono::steady_clock::now();
+                const auto data = loader.loadIR(file, sampleRate, options.blockSize);
+                timing.fileMs = millisecondsSince(start);
+                if (data == nullptr)
+                    return {};
+            }
+            {
+                IRLoader loader;
+                loader.setNumLoadThreads(threads);
+                const auto start = std::chrono::steady_clock::now();
+                const auto data = loader.loadIR(ir, sampleRate, options.blockSize);
+                timing.memoryMs = millisecondsSince(start);
+            }
+            {
+                IRLoader loader;
+                loader.setNumLoadThreads(threads);
+                loader.setProgressiveLoading(true);
+                const auto start = std::chrono::steady_clock::now();
+                const auto data = loader.loadIR(file, sampleRate, options.blockSize);
+                timing.firstAudioMs = millisecondsSince(start);
+                while (data != nullptr && !data->isComplete())
+                    std::this_thread::yield();
+                timing.completeMs = millisecondsSince(start);
+            }
+
+            if (run == 0)
+                best = timing;
+            best.fileMs = std::min(best.fileMs, timing.fileMs);
+            best.memoryMs = std::min(best.memoryMs, timing.memoryMs);
+            best.firstAudioMs = std::min(best.firstAudioMs, timing.firstAudioMs);
+            best.completeMs = std::min(best.completeMs, timing.completeMs);
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArguments(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Keeps the shared transform threads alive between the timed loaders.
+    IRLoader pool;
+    if (options.threadCounts.empty())
+    {
+        const int maxThreads = pool.getNumLoadThreads();
+        for (int threads = 1; threads < maxThreads; threads *= 2)
+            options.threadCounts.push_back(threads);
+        options.threadCounts.push_back(maxThreads);
+    }
+
+    IRCache::setDiskCacheDirectory({});
+    const auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("IRLoadBenchmark");
+    directory.createDirectory();
+
+    std::printf("FFT backend %s, %d channels, block %d, best of %d\n", FftBackend::getName(FftBackend::getDefaultKind()),
+                options.channels, options.blockSize, options.runs);
+    std::printf("%8s %8s %10s %10s %8s %12s %12s\n", "IR s", "threads", "file ms", "memory ms", "speedup", "first ms",
+                "complete ms");
+
+    int status = 0;
+    for (const double seconds : options.irSeconds)
+    {
+        const auto ir = BenchmarkIRs::makeDecayingNoise(seconds, sampleRate, options.channels);
+        const auto file = directory.getChildFile("ir_" + juce::String(seconds) + "s.wav");
+        if (!writeWav(file, ir))
+        {
+            std::fprintf(stderr, "cannot write %s\n", file.getFullPathName().toRawUTF8());
+            status = 1;
+            continue;
+        }
+
+        double singleThreadMs = 0.0;
+        for (const int threads : options.threadCounts)
+        {
+            const auto timing = timeLoads(options, file, ir, threads);
+            if (!timing.loaded)
+            {
+                std::fprintf(stderr, "cannot load %s\n", file.getFullPathName().toRawUTF8());
+                status = 1;
+                break;
+            }
+
+            if (singleThreadMs == 0.0)
+                singleThreadMs = timing.fileMs;
+
+            std::printf("%8.1f %8d %10.1f %10.1f %7.2fx %12.2f %12.1f\n", seconds, threads, timing.fileMs, timing.memoryMs,
+                        timing.fileMs > 0.0 ? singleThreadMs / timing.fileMs : 0.0, timing.firstAudioMs, timing.completeMs);
+        }
+
+        file.deleteFile();
+    }
+
+    directory.deleteRecursively();
+    return status;
+}